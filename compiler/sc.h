@@ -743,6 +743,7 @@ void cell2addr(void);
 void cell2addr_alt(void);
 void char2addr(void);
 void addconst(cell value);
+void mulconst(cell value);
 void setheap_save(cell value);
 void stradjust(regid reg);
 void invoke_getter(struct methodmap_method_s *method);
@@ -797,6 +798,7 @@ void errorset(int code,int line);
 
 /* function prototypes in SC6.C */
 void assemble(const char *outname, void *fin);
+void mark_format_string(cell address);
 
 /* function prototypes in SC7.C */
 void stgbuffer_cleanup(void);
@@ -868,6 +870,7 @@ extern char *inpfname;      /* name of the file currently read from */
 extern char outfname[];     /* intermediate (assembler) file name */
 extern char binfname[];     /* binary file name */
 extern char errfname[];     /* error file name */
+extern char proffname[];    /* method profile written by the VM, if any */
 extern char sc_ctrlchar;    /* the control character (or escape character) */
 extern char sc_ctrlchar_org;/* the default control character */
 extern int litidx;          /* index to literal table */
@@ -885,6 +888,8 @@ extern int sc_debug;        /* debug/optimization options (bit field) */
 extern int sc_packstr;      /* strings are packed by default? */
 extern int sc_asmfile;      /* create .ASM file? */
 extern int sc_listing;      /* create .LST file? */
+extern int sc_compactcode;  /* emit varint-encoded code? */
+extern int sc_flatarrays;   /* index fixed 2-D arrays without the indirection vector? */
 extern int sc_needsemicolon;/* semicolon required to terminate expressions? */
 extern int sc_dataalign;    /* data alignment value */
 extern int pc_docexpr;      /* must expression be attached to documentation comment? */
@@ -127,6 +127,7 @@ static int newfunc(declinfo_t *decl, const int *thistag, int fpublic, int fstati
 static int declargs(symbol *sym, int chkshadow, const int *thistag);
 static void doarg(symbol *sym, declinfo_t *decl, int offset, int chkshadow, arginfo *arg);
 static void reduce_referrers(symbol *root);
+static long max_stack_usage(symbol *root,int *recursion);
 static int testsymbols(symbol *root,int level,int testlabs,int testconst);
 static void destructsymbols(symbol *root,int level);
 static void statement(int *lastindent,int allow_decl);
@@ -462,6 +463,14 @@ cleanup:
         pc_printf("Code size:         %8ld bytes\n", (long)code_idx);
         pc_printf("Data size:         %8ld bytes\n", (long)glb_declared*sizeof(cell));
         pc_printf("Stack/heap size:   %8ld bytes\n", (long)pc_stksize*sizeof(cell));
+        int recursion=FALSE;
+        long stack=max_stack_usage(&glbtab,&recursion);
+        if (recursion)
+          pc_printf("Max. stack usage:  unknown (recursion)\n");
+        else if (stack>pc_stksize)
+          pc_printf("Max. stack usage:  %8ld bytes (exceeds stack/heap size)\n", stack*(long)sizeof(cell));
+        else
+          pc_printf("Max. stack usage:  %8ld bytes\n", stack*(long)sizeof(cell));
         pc_printf("Total requirements:%8ld bytes\n", (long)code_idx+(long)glb_declared*sizeof(cell)+(long)pc_stksize*sizeof(cell));
       } /* if */
     } /* if */
@@ -669,6 +678,8 @@ static void initglobals(void)
 
   sc_asmfile=FALSE;     /* do not create .ASM file */
   sc_listing=FALSE;     /* do not create .LST file */
+  sc_compactcode=FALSE; /* emit plain cells in the code section */
+  sc_flatarrays=FALSE;  /* load rows through the indirection vectors */
   skipinput=0;          /* number of lines to skip from the first input file */
   sc_ctrlchar=CTRL_CHAR;/* the escape character */
   litmax=sDEF_LITMAX;   /* current size of the literal table */
@@ -688,6 +699,7 @@ static void initglobals(void)
 
   outfname[0]='\0';     /* output file name */
   errfname[0]='\0';     /* error file name */
+  proffname[0]='\0';    /* method profile file name */
   inpf=NULL;            /* file read from */
   inpfname=NULL;        /* pointer to name of the file currently read from */
   outf=NULL;            /* file written to */
@@ -824,6 +836,11 @@ static void parseoptions(int argc,char **argv,char *oname,char *ename,char *pnam
           hwndFinish=(HWND)0;
         break;
 #endif
+      case 'f':
+        if (*(ptr+1)!='\0')
+          about();
+        sc_flatarrays=TRUE;     /* compute row addresses of fixed 2-D arrays */
+        break;
       case 'h':
         sc_showincludes = 1;
         break;
@@ -838,6 +855,11 @@ static void parseoptions(int argc,char **argv,char *oname,char *ename,char *pnam
           insert_path(str);
         } /* if */
         break;
+      case 'k':
+        if (*(ptr+1)!='\0')
+          about();
+        sc_compactcode=TRUE;    /* varint-encode the code section */
+        break;
       case 'l':
         if (*(ptr+1)!='\0')
           about();
@@ -854,6 +876,9 @@ static void parseoptions(int argc,char **argv,char *oname,char *ename,char *pnam
       case 'p':
         strlcpy(pname,option_value(ptr,argv,argc,&arg),_MAX_PATH); /* set name of implicit include file */
         break;
+      case 'P':
+        strlcpy(proffname,option_value(ptr,argv,argc,&arg),_MAX_PATH); /* set name of method profile */
+        break;
       case 's':
         skipinput=atoi(option_value(ptr,argv,argc,&arg));
         break;
@@ -1107,8 +1132,10 @@ static void about(void)
 #if defined __WIN32__ || defined _WIN32 || defined _Windows
     pc_printf("         -H<hwnd> window handle to send a notification message on finish\n");
 #endif
+    pc_printf("         -f       flat row addressing for fixed-size two-dimensional arrays\n");
     pc_printf("         -h       show included file paths\n");
     pc_printf("         -i<name> path for include files\n");
+    pc_printf("         -k       compact code encoding (needs a VM with code version 12)\n");
     pc_printf("         -l       create list file (preprocess only)\n");
     pc_printf("         -o<name> set base name of (P-code) output file\n");
     pc_printf("         -O<num>  optimization level (default=-O%d)\n",pc_optimize);
@@ -1118,6 +1145,8 @@ static void about(void)
 #endif
     pc_printf("             2    full optimizations\n");
     pc_printf("         -p<name> set name of \"prefix\" file\n");
+    pc_printf("         -P<name> method profile written by the VM; only raises the inline\n");
+    pc_printf("                  budget of frequently called stocks without arguments\n");
     pc_printf("         -s<num>  skip lines from the input file\n");
     pc_printf("         -t<num>  TAB indent size (in character positions, default=%d)\n",sc_tabsize);
     pc_printf("         -v<num>  verbosity level; 0=quiet, 1=normal, 2=verbose (default=%d)\n",verbosity);
@@ -4985,6 +5014,102 @@ static int count_referrers(symbol *entry)
   return count;
 }
 
+/* Worst-case stack usage of calls, computed over the call graph that the
+ * referrer lists describe. A function that is referred to without being
+ * called (e.g. passed as a callback) is still counted as a callee, since a
+ * native may invoke it on top of the caller's stack.
+ */
+#define sFRAME_OVERHEAD 2       /* saved frame pointer and return address */
+
+typedef struct s_stackinfo {
+  symbol *sym;
+  long depth;                   /* stack use of a call, in cells */
+  int state;                    /* 0 = not visited, 1 = active, 2 = done */
+} stackinfo;
+
+static int is_referred_by(symbol *entry,symbol *bywhom)
+{
+  int i;
+
+  for (i=0; i<entry->numrefers; i++)
+    if (entry->refer[i]==bywhom)
+      return TRUE;
+  return FALSE;
+}
+
+static long call_stack_usage(stackinfo *table,int count,stackinfo *info,int *recursion)
+{
+  long deepest,depth;
+  int i;
+
+  if (info->state==2)
+    return info->depth;
+  if (info->state==1) {
+    *recursion=TRUE;            /* the depth of a cycle has no bound */
+    return 0;
+  } /* if */
+
+  info->state=1;
+  deepest=0;
+  for (i=0; i<count; i++) {
+    if (!is_referred_by(table[i].sym,info->sym))
+      continue;
+    depth=call_stack_usage(table,count,&table[i],recursion);
+    if (depth>deepest)
+      deepest=depth;
+  } /* for */
+  info->state=2;
+  info->depth=info->sym->x.stacksize+sFRAME_OVERHEAD+deepest;
+  return info->depth;
+}
+
+/*  max_stack_usage
+ *
+ *  Returns the largest number of stack cells that a call into any public
+ *  function can use, including the arguments pushed by the host. If the
+ *  call graph has a cycle, "recursion" is set and the result is a lower
+ *  bound only.
+ */
+static long max_stack_usage(symbol *root,int *recursion)
+{
+  stackinfo *table;
+  symbol *sym;
+  arginfo *arg;
+  long maximum,depth;
+  int count,i;
+
+  count=0;
+  for (sym=root->next; sym!=NULL; sym=sym->next)
+    if (sym->ident==iFUNCTN && (sym->usage & (uDEFINE|uNATIVE))==uDEFINE)
+      count++;
+  if (count==0)
+    return 0;
+  if ((table=(stackinfo*)calloc(count,sizeof(stackinfo)))==NULL)
+    return 0;                   /* this is only an estimate, so give up */
+
+  i=0;
+  for (sym=root->next; sym!=NULL; sym=sym->next)
+    if (sym->ident==iFUNCTN && (sym->usage & (uDEFINE|uNATIVE))==uDEFINE)
+      table[i++].sym=sym;
+
+  maximum=0;
+  for (i=0; i<count; i++) {
+    sym=table[i].sym;
+    if ((sym->usage & uPUBLIC)==0)
+      continue;
+    depth=call_stack_usage(table,count,&table[i],recursion);
+    /* the host pushes the arguments and the argument count */
+    depth++;
+    for (arg=sym->dim.arglist; arg!=NULL && arg->ident!=0; arg++)
+      depth+=(arg->ident==iVARARGS) ? SP_MAX_EXEC_PARAMS : 1;
+    if (depth>maximum)
+      maximum=depth;
+  } /* for */
+
+  free(table);
+  return maximum;
+}
+
 /* Every symbol has a referrer list, that contains the functions that use
  * the symbol. Now, if function "apple" is accessed by functions "banana" and
  * "citron", but neither function "banana" nor "citron" are used by anyone
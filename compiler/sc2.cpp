@@ -1830,6 +1830,9 @@ token_buffer_t sNormalBuffer;
 token_buffer_t sPreprocessBuffer;
 token_buffer_t *sTokenBuffer;
 
+// Text of the string literal being lexed; see full_token_t.
+static char sStringText[sLINEMAX + 1];
+
 static full_token_t *current_token()
 {
   return &sTokenBuffer->tokens[sTokenBuffer->cursor];
@@ -2044,6 +2047,7 @@ int lex(cell *lexvalue,char **lexsym)
   full_token_t *tok = advance_token_ptr();
   tok->id = 0;
   tok->value = 0;
+  tok->str = tok->name;
   tok->str[0] = '\0';
   tok->len = 0;
 
@@ -2201,6 +2205,7 @@ int lex(cell *lexvalue,char **lexsym)
     char *cat;
     tok->id = tSTRING;
     *lexvalue = tok->value = litidx;
+    *lexsym = tok->str = sStringText;
     tok->str[0]='\0';
     stringflags=-1;       /* to mark the first segment */
     for ( ;; ) {
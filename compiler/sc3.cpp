@@ -1855,7 +1855,7 @@ int
 SC3ExpressionParser::hier1(value *lval1)
 {
   int lvalue,index,tok;
-  cell val,cidx;
+  cell val,cidx,flat_rowsize;
   value lval2={0};
   char *st;
   char close;
@@ -1915,6 +1915,16 @@ restart:
       } /* if */
       /* set the tag to match (enumeration fields as indices) */
       lval2.cmptag=sym->x.tags.index;
+      /* with -f, a fixed-size two-dimensional array is indexed as a flat,
+       * row-major block: the rows follow the indirection vector and all have
+       * the same length, so the row address can be computed rather than read
+       * from the vector
+       */
+      flat_rowsize=0;
+      if (sc_flatarrays && sym->ident==iARRAY && sym->dim.array.level==1
+          && sym->parent==NULL && sym->tag!=pc_tag_string
+          && sym->dim.array.length!=0)
+        flat_rowsize=finddepend(sym)->dim.array.length;
       stgget(&index,&cidx);     /* mark position in code generator */
       pushreg(sPRI);            /* save base address of the array */
       if (hier14(&lval2))       /* create expression for the array index */
@@ -1934,7 +1944,11 @@ restart:
           /* normal array index */
           if (lval2.constval<0 || (sym->dim.array.length!=0 && sym->dim.array.length<=lval2.constval))
             error(32,sym->name);        /* array index out of bounds */
-          if (lval2.constval!=0) {
+          if (flat_rowsize!=0) {
+            /* skip the indirection vector, then whole rows */
+            ldconst((sym->dim.array.length+lval2.constval*flat_rowsize)*sizeof(cell),sALT);
+            ob_add();
+          } else if (lval2.constval!=0) {
             /* don't add offsets for zero subscripts */
             #if PAWN_CELL_SIZE==16
               ldconst(lval2.constval<<1,sALT);
@@ -1982,6 +1996,10 @@ restart:
             ffbounds(sym->dim.array.length-1);  /* run time check for array bounds */
           else
             ffbounds();
+          if (flat_rowsize!=0) {
+            mulconst(flat_rowsize);     /* cells to the start of the row... */
+            addconst(sym->dim.array.length);  /* ...past the indirection vector */
+          } /* if */
           cell2addr();  /* normal array index */
         } else {
           if (sym->dim.array.length!=0)
@@ -1997,12 +2015,14 @@ restart:
       assert(cursym==sym && sym!=NULL); /* should still be set */
       if (sym->dim.array.level>0) {
         assert(cursym==lval1->sym);
-        /* read the offset to the subarray and add it to the current address */
-        lval1->ident=iARRAYCELL;
-        pushreg(sPRI);          /* the optimizer makes this to a MOVE.alt */
-        rvalue(lval1);
-        popreg(sALT);
-        ob_add();
+        if (flat_rowsize==0) {
+          /* read the offset to the subarray and add it to the current address */
+          lval1->ident=iARRAYCELL;
+          pushreg(sPRI);        /* the optimizer makes this to a MOVE.alt */
+          rvalue(lval1);
+          popreg(sALT);
+          ob_add();
+        } /* if */
         /* adjust the "value" structure and find the referenced array */
         lval1->ident=iREFARRAY;
         lval1->sym=finddepend(sym);
@@ -2860,6 +2880,18 @@ SC3ExpressionParser::callfunction(symbol *sym, const svalue *aImplicitThis, valu
 
           if (lval.tag!=0)
             append_constval(&taglst,arg[argidx].name,lval.tag,0);
+          /* A string literal passed as the format of a native, i.e. a
+           * const string followed by variadic arguments, is handed to the
+           * assembler to be pre-parsed. The literal was the last one added
+           * to the table, and |constval| is minus its size.
+           */
+          if (sc_status==statWRITE && (sym->usage & uNATIVE)!=0
+              && lval.sym==NULL && lval.ident==iARRAY && lval.constval<0
+              && lval.tag==pc_tag_string && (arg[argidx].usage & uCONST)!=0
+              && arg[argidx+1].ident==iVARARGS)
+          {
+            mark_format_string((litidx+lval.constval+glb_declared)*sizeof(cell));
+          } /* if */
           // ??? set uWRITTEN?
           argidx++;               /* argument done */
           break;
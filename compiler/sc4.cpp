@@ -892,6 +892,18 @@ void addconst(cell value)
   } /* if */
 }
 
+/*
+ *  Multiply the primary register by a constant.
+ */
+void mulconst(cell value)
+{
+  if (value!=1) {
+    stgwrite("\tsmul.c ");
+    outval(value,TRUE);
+    code_idx+=opcodes(1)+opargs(1);
+  } /* if */
+}
+
 /*
  *  signed multiply of primary and secundairy registers (result in primary)
  */
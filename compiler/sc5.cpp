@@ -55,6 +55,38 @@ static unsigned char warndisable[(NUM_WARNINGS + 7) / 8]; /* 8 flags in a char *
 
 static int errflag;
 
+static ErrorType
+classify_error(int number)
+{
+  if (number < FIRST_FATAL_ERROR || (number >= 200 && sc_warnings_are_errors))
+    return ErrorType::Error;
+  if (number < 200)
+    return ErrorType::Fatal;
+
+  /* also check for disabled warnings */
+  int index=(number-200)/8;
+  int mask=1 << ((number-200)%8);
+  if ((warndisable[index] & mask)!=0)
+    return ErrorType::Suppressed;
+  return ErrorType::Warning;
+}
+
+/*  is_error_silenced
+ *
+ *  Returns whether report_error() would drop a message of the given type
+ *  without any side effects. Such messages are never formatted, which keeps
+ *  the first pass and files with many disabled warnings cheap.
+ */
+static bool
+is_error_silenced(ErrorType type)
+{
+  if (type == ErrorType::Fatal)
+    return false;
+  if (type == ErrorType::Suppressed || errflag)
+    return true;
+  return sc_status != statWRITE && !sc_err_status;
+}
+
 /*  error
  *
  *  Outputs an error message (note: msg is passed optionally).
@@ -69,6 +101,9 @@ static int errflag;
  */
 int error(int number,...)
 {
+  if (is_error_silenced(classify_error(number)))
+    return 0;
+
   va_list ap;
   va_start(ap, number);
   ErrorReport report = ErrorReport::infer_va(number, ap);
@@ -80,6 +115,9 @@ int error(int number,...)
 
 int error(symbol* sym, int number, ...)
 {
+  if (is_error_silenced(classify_error(number)))
+    return 0;
+
   va_list ap;
   va_start(ap, number);
   ErrorReport report = ErrorReport::create_va(
@@ -121,20 +159,11 @@ ErrorReport::create_va(int number,
   else
     report.filename = inpfname;
 
-  if (number < FIRST_FATAL_ERROR || (number >= 200 && sc_warnings_are_errors))
-    report.type = ErrorType::Error;
-  else if (number < 200)
-    report.type = ErrorType::Fatal;
-  else
-    report.type = ErrorType::Warning;
+  report.type = classify_error(number);
 
-  /* also check for disabled warnings */
-  if (report.type == ErrorType::Warning) {
-    int index=(report.number-200)/8;
-    int mask=1 << ((report.number-200)%8);
-    if ((warndisable[index] & mask)!=0)
-      report.type = ErrorType::Suppressed;
-  }
+  /* don't bother formatting messages that will never be printed */
+  if (is_error_silenced(report.type))
+    return report;
 
   const char* prefix = "";
   switch (report.type) {
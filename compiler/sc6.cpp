@@ -82,6 +82,32 @@ typedef struct {
 
 static cell *LabelTable;    /* label table */
 
+// Inlining a call site changes the size of the code, so every code address
+// computed by the code generator (function addresses, debug information) has
+// to be shifted by the accumulated size difference of the call sites that
+// precede it. Entries are sorted by |orig|.
+struct AddressShift {
+  cell orig;    // first address (as computed by the code generator) to shift
+  cell delta;   // bytes to add to addresses at or after |orig|
+};
+static Vector<AddressShift> AddressShifts;
+
+static cell remap_code_address(cell addr)
+{
+  size_t low = 0;
+  size_t high = AddressShifts.length();
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (AddressShifts[mid].orig <= addr)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low == 0)
+    return addr;
+  return addr + AddressShifts[low - 1].delta;
+}
+
 /* apparently, strtol() does not work correctly on very large (unsigned)
  * hexadecimal values */
 static ucell hex2long(const char *s,char **n)
@@ -274,7 +300,7 @@ static void do_call(CellWriter* writer, char *params, cell opcode)
   symbol* sym = extract_call_target(params);
 
   writer->append(opcode);
-  writer->append(sym->addr());
+  writer->append(remap_code_address(sym->addr()));
 }
 
 static void do_jump(CellWriter* writer, char *params, cell opcode)
@@ -476,89 +502,372 @@ static int findopcode(char *instr,int maxlen)
   return 0;             /* not found, return special index */
 }
 
-// This pass is necessary because the code addresses of labels is only known
-// after the peephole optimization flag. Labels can occur inside expressions
-// (e.g. the conditional operator), which are optimized.
-static void relocate_labels(void *fin)
+// Small stocks are copied into their callers instead of being called. Since
+// the assembler has no view of the caller's frame, only functions that take
+// no arguments qualify, and their bodies may only contain instructions that
+// neither touch the frame nor transfer control nor fault. This keeps stack
+// traces and debug line attribution exact: nothing in an inlined body can
+// raise an error, so the caller's line is always the right one to report.
+static const int kMaxInlineInstructions = 4;
+
+// Stocks that a VM profile (-P) shows as entered at least this often get a
+// larger budget, since every call avoided there is a call avoided at runtime.
+// This is the only use of the profile: it does not inline stocks that take
+// arguments, and it does not reorder or outline cold code.
+static const unsigned kHotInvocationCount = 1000;
+static const int kMaxHotInlineInstructions = 8;
+
+struct InlineCandidate {
+  symbol *sym;
+  Vector<AString> body;
+};
+static Vector<InlineCandidate> InlineCandidates;
+
+static bool is_inlinable_opcode(cell opcode)
 {
-  if (sc_labnum <= 0)
-    return;
+  switch (opcode) {
+    case sp::OP_ADD:
+    case sp::OP_ADD_C:
+    case sp::OP_AND:
+    case sp::OP_CONST_ALT:
+    case sp::OP_CONST_PRI:
+    case sp::OP_DEC:
+    case sp::OP_DEC_ALT:
+    case sp::OP_DEC_PRI:
+    case sp::OP_EQ:
+    case sp::OP_EQ_C_ALT:
+    case sp::OP_EQ_C_PRI:
+    case sp::OP_INC:
+    case sp::OP_INC_ALT:
+    case sp::OP_INC_PRI:
+    case sp::OP_INVERT:
+    case sp::OP_LOAD_ALT:
+    case sp::OP_LOAD_BOTH:
+    case sp::OP_LOAD_PRI:
+    case sp::OP_MOVE_ALT:
+    case sp::OP_MOVE_PRI:
+    case sp::OP_NEG:
+    case sp::OP_NEQ:
+    case sp::OP_NOP:
+    case sp::OP_NOT:
+    case sp::OP_OR:
+    case sp::OP_SGEQ:
+    case sp::OP_SGRTR:
+    case sp::OP_SHL:
+    case sp::OP_SHL_C_ALT:
+    case sp::OP_SHL_C_PRI:
+    case sp::OP_SHR:
+    case sp::OP_SLEQ:
+    case sp::OP_SLESS:
+    case sp::OP_SMUL:
+    case sp::OP_SMUL_C:
+    case sp::OP_SSHR:
+    case sp::OP_STOR_ALT:
+    case sp::OP_STOR_PRI:
+    case sp::OP_SUB:
+    case sp::OP_SUB_ALT:
+    case sp::OP_XCHG:
+    case sp::OP_XOR:
+    case sp::OP_ZERO:
+    case sp::OP_ZERO_ALT:
+    case sp::OP_ZERO_PRI:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Splits an assembly line into its instruction and parameters, and returns
+// the opcode table entry for it. Returns null for empty lines and labels.
+static OPCODEC *parse_instruction(char *line, char **instrp, char **paramsp)
+{
+  stripcomment(line);
+  char *instr = skipwhitespace(line);
+
+  // Ignore empty lines and labels.
+  if (*instr == '\0' || (tolower(*instr) == 'l' && *(instr + 1) == '.')) {
+    *instrp = instr;
+    return nullptr;
+  }
 
-  assert(!LabelTable);
-  LabelTable = (cell *)calloc(sc_labnum, sizeof(cell));
+  // Get to the end of the instruction (make use of the '\n' that fgets()
+  // added at the end of the line; this way we will *always* drop on a
+  // whitespace character.
+  char *params;
+  for (params = instr; *params != '\0' && !isspace(*params); params++) {
+    // Do nothing.
+  }
+  assert(params > instr);
+
+  int op_index = findopcode(instr, (int)(params - instr));
+  OPCODEC &op = opcodelist[op_index];
+  if (!op.name) {
+    *params = '\0';
+    error(104, instr);
+  }
+
+  *instrp = instr;
+  *paramsp = skipwhitespace(params);
+  return &op;
+}
+
+static bool is_inline_candidate(symbol *sym)
+{
+  if (sym->ident != iFUNCTN || sym->vclass != sGLOBAL)
+    return false;
+  if ((sym->usage & (uSTOCK|uDEFINE|uREAD)) != (uSTOCK|uDEFINE|uREAD))
+    return false;
+  if (sym->usage & (uPUBLIC|uNATIVE|uMISSING))
+    return false;
+  return sym->dim.arglist && sym->dim.arglist[0].ident == 0;
+}
+
+// Read the names of frequently entered functions from a profile written by
+// the VM. Each line is "<pcode offset> <count> <name>"; offsets refer to the
+// binary that was profiled, so only the names are used.
+static void read_hot_functions(Vector<AString> *hot)
+{
+  FILE *fp = fopen(proffname, "rt");
+  if (!fp) {
+    error(FATAL_ERROR_READ, proffname);
+    return;
+  }
 
   char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    unsigned offset, count;
+    char name[sizeof(line)];
+    if (sscanf(line, "%u %u %255s", &offset, &count, name) != 3)
+      continue;
+    if (count >= kHotInvocationCount)
+      hot->append(AString(name));
+  }
+  fclose(fp);
+}
+
+static bool is_hot_function(const Vector<AString> &hot, symbol *sym)
+{
+  for (size_t i = 0; i < hot.length(); i++) {
+    if (strcmp(hot[i].chars(), sym->name) == 0)
+      return true;
+  }
+  return false;
+}
+
+static int sort_by_addr(const void *a1, const void *a2);
+
+// Scan every function eligible for inlining, and remember the bodies that
+// are small and simple enough.
+static void find_inline_candidates(void *fin)
+{
+  if (pc_optimize < sOPTIMIZE_DEFAULT)
+    return;
+
+  Vector<AString> hot;
+  if (proffname[0] != '\0')
+    read_hot_functions(&hot);
+
+  Vector<symbol *> stocks;
+  for (symbol *sym = glbtab.next; sym; sym = sym->next) {
+    if (is_inline_candidate(sym))
+      stocks.append(sym);
+  }
+  if (stocks.empty())
+    return;
+  qsort(stocks.buffer(), stocks.length(), sizeof(symbol *), sort_by_addr);
+
+  size_t next_stock = 0;
+  InlineCandidate current;
+  bool collecting = false;
+  bool returned = false;
+  size_t budget = kMaxInlineInstructions;
+
+  auto finish = [&]() -> void {
+    if (collecting && returned)
+      InlineCandidates.append(ke::Move(current));
+    current.sym = nullptr;
+    current.body.clear();
+    collecting = false;
+  };
 
+  char line[256];
   CellWriter writer(nullptr);
 
   pc_resetasm(fin);
   while (pc_readasm(fin, line, sizeof(line))) {
-    stripcomment(line);
-
-    char *instr = skipwhitespace(line);
-    if (*instr == '\0') // Ignore empty lines.
+    char *instr, *params;
+    OPCODEC *op = parse_instruction(line, &instr, &params);
+    if (!op) {
+      // Labels mean the body has control flow.
+      if (*instr != '\0')
+        collecting = false;
+      continue;
+    }
+    if (op->segment != sIN_CSEG)
       continue;
 
-    if (tolower(*instr) == 'l' && *(instr + 1) == '.') {
-      int lindex = (int)hex2long(instr + 2, nullptr);
-      assert(lindex >= 0 && lindex < sc_labnum);
-      LabelTable[lindex] = writer.current_index();
-    } else {
-      // Get to the end of the instruction (make use of the '\n' that fgets()
-      // added at the end of the line; this way we *always* drop on a whitespace
-      // character.
-      char *params;
-      for (params = instr; *params != '\0' && !isspace(*params); params++) {
-        // Nothing.
+    cell addr = writer.current_index();
+    op->func(&writer, params, op->opcode);
+
+    if (op->opcode == sp::OP_PROC) {
+      finish();
+      while (next_stock < stocks.length() && stocks[next_stock]->addr() < addr)
+        next_stock++;
+      if (next_stock < stocks.length() && stocks[next_stock]->addr() == addr) {
+        current.sym = stocks[next_stock];
+        collecting = true;
+        returned = false;
+        budget = is_hot_function(hot, current.sym)
+                 ? kMaxHotInlineInstructions
+                 : kMaxInlineInstructions;
       }
-      assert(params > instr);
+      continue;
+    }
 
-      int op_index = findopcode(instr, (int)(params - instr));
-      OPCODEC &op = opcodelist[op_index];
-      if (!op.name) {
-        *params = '\0';
-        error(104, instr);
-      }
+    if (!collecting || op->opcode == sp::OP_BREAK || op->opcode == 0)
+      continue;
 
-      if (op.segment == sIN_CSEG)
-        op.func(&writer, skipwhitespace(params), op.opcode);
+    if (op->opcode == sp::OP_RETN && !returned) {
+      returned = true;
+      continue;
+    }
+    if (returned ||
+        !is_inlinable_opcode(op->opcode) ||
+        current.body.length() >= budget)
+    {
+      collecting = false;
+      continue;
     }
+
+    current.body.append(AString(instr));
   }
+  finish();
 }
 
-// Generate code or data into a buffer.
-static void generate_segment(Vector<cell> *buffer, void *fin, int pass)
+static InlineCandidate *find_inline_candidate(char *params)
 {
-  pc_resetasm(fin);
+  if (InlineCandidates.empty())
+    return nullptr;
+
+  symbol *sym = extract_call_target(params);
+  for (size_t i = 0; i < InlineCandidates.length(); i++) {
+    if (InlineCandidates[i].sym == sym)
+      return &InlineCandidates[i];
+  }
+  return nullptr;
+}
+
+static void emit_inline_body(CellWriter* writer, const InlineCandidate &candidate)
+{
+  char line[256];
+  for (size_t i = 0; i < candidate.body.length(); i++) {
+    SafeStrcpy(line, sizeof(line), candidate.body[i].chars());
+
+    char *instr, *params;
+    OPCODEC *op = parse_instruction(line, &instr, &params);
+    assert(op && op->segment == sIN_CSEG);
+    op->func(writer, params, op->opcode);
+  }
+}
+
+// Walk the assembly buffer and generate code or data. When |relocating|, this
+// is a sizing pass that fills the label table and the address shift table
+// instead; it is necessary because the code addresses of labels are only
+// known after the peephole optimization pass. Labels can occur inside
+// expressions (e.g. the conditional operator), which are optimized.
+static void walk_segment(CellWriter* writer, void *fin, int pass, bool relocating)
+{
+  // Number of bytes the code generator assumed for everything before the
+  // current instruction.
+  cell orig_index = 0;
+
+  // A "push.c 0" that may be the argument count of an inlinable call.
+  bool pending_push = false;
+  char pending_line[256];
+
+  auto flush_pending = [&]() -> void {
+    if (!pending_push)
+      return;
+    char *instr, *params;
+    OPCODEC *op = parse_instruction(pending_line, &instr, &params);
+    cell before = writer->current_index();
+    op->func(writer, params, op->opcode);
+    orig_index += writer->current_index() - before;
+    pending_push = false;
+  };
 
-  char line[255];
+  char line[256];
+
+  pc_resetasm(fin);
   while (pc_readasm(fin, line, sizeof(line))) {
-    stripcomment(line);
-    char *instr = skipwhitespace(line);
-    
-    // Ignore empty lines and labels.
-    if (*instr=='\0' || (tolower(*instr) == 'l' && *(instr + 1)=='.'))
+    char *instr, *params;
+    OPCODEC *op = parse_instruction(line, &instr, &params);
+    if (!op) {
+      if (*instr != '\0') {
+        flush_pending();
+        if (relocating) {
+          int lindex = (int)hex2long(instr + 2, nullptr);
+          assert(lindex >= 0 && lindex < sc_labnum);
+          LabelTable[lindex] = writer->current_index();
+        }
+      }
       continue;
-
-    // Get to the end of the instruction (make use of the '\n' that fgets()
-    // added at the end of the line; this way we will *always* drop on a
-    // whitespace character) */
-    char *params;
-    for (params=instr; *params != '\0' && !isspace(*params); params++) {
-      // Do nothing.
     }
-    assert(params > instr);
 
-    int op_index = findopcode(instr, (int)(params-instr));
-    OPCODEC &op = opcodelist[op_index];
-    assert(op.name != nullptr);
-
-    if (op.segment != pass)
+    if (op->segment != pass)
       continue;
 
-    CellWriter writer(buffer);
-    op.func(&writer, skipwhitespace(params), op.opcode);
+    if (pass == sIN_CSEG && !InlineCandidates.empty()) {
+      if (pending_push && op->opcode == sp::OP_CALL) {
+        if (InlineCandidate *candidate = find_inline_candidate(params)) {
+          emit_inline_body(writer, *candidate);
+
+          // The code generator sized this call site as "push.c 0 / call".
+          orig_index += opcodes(2) + opargs(2);
+          if (relocating) {
+            AddressShift shift;
+            shift.orig = orig_index;
+            shift.delta = writer->current_index() - orig_index;
+            AddressShifts.append(shift);
+          }
+          pending_push = false;
+          continue;
+        }
+      }
+      flush_pending();
+
+      if (op->opcode == sp::OP_PUSH_C && getparam(params, nullptr) == 0) {
+        SafeStrcpy(pending_line, sizeof(pending_line), instr);
+        pending_push = true;
+        continue;
+      }
+    }
+
+    cell before = writer->current_index();
+    op->func(writer, params, op->opcode);
+    orig_index += writer->current_index() - before;
   }
+  flush_pending();
+}
+
+static void relocate_labels(void *fin)
+{
+  if (sc_labnum > 0) {
+    assert(!LabelTable);
+    LabelTable = (cell *)calloc(sc_labnum, sizeof(cell));
+  }
+
+  find_inline_candidates(fin);
+
+  CellWriter writer(nullptr);
+  walk_segment(&writer, fin, sIN_CSEG, true);
+}
+
+// Generate code or data into a buffer.
+static void generate_segment(Vector<cell> *buffer, void *fin, int pass)
+{
+  CellWriter writer(buffer);
+  walk_segment(&writer, fin, pass, false);
 }
 
 #if !defined NDEBUG
@@ -672,7 +981,7 @@ static void append_debug_tables(SmxBuilder *builder, StringPool &pool, RefPtr<Sm
     switch (str.kind()) {
       case 'F':
       {
-        ucell codeidx = str.parse();
+        ucell codeidx = remap_code_address(str.parse());
         if (codeidx != prev_file_addr) {
           if (prev_file_name) {
             sp_fdbg_file_t &entry = files->add();
@@ -688,7 +997,7 @@ static void append_debug_tables(SmxBuilder *builder, StringPool &pool, RefPtr<Sm
       case 'L':
       {
         sp_fdbg_line_t &entry = lines->add();
-        entry.addr = str.parse();
+        entry.addr = remap_code_address(str.parse());
         entry.line = str.parse();
         break;
       }
@@ -707,10 +1016,12 @@ static void append_debug_tables(SmxBuilder *builder, StringPool &pool, RefPtr<Sm
         char *nameend = str.skipto(' ');
         Atom *atom = pool.add(name, nameend - name);
 
-        sym.codestart = str.parse();
-        sym.codeend = str.parse();
+        sym.codestart = remap_code_address(str.parse());
+        sym.codeend = remap_code_address(str.parse());
         sym.ident = (char)str.parse();
         sym.vclass = (char)str.parse();
+        if (sym.ident == iFUNCTN)
+          sym.addr = remap_code_address(sym.addr);
         sym.dimcount = 0;
         sym.name = dbgnames->add(atom);
 
@@ -799,13 +1110,106 @@ static void append_debug_tables(SmxBuilder *builder, StringPool &pool, RefPtr<Sm
   builder->add(tags);
 }
 
+// Stores each cell as a zigzag LEB128 varint. Opcodes and most operands
+// (small constants, frame offsets) fit in a single byte.
+static void encode_compact_code(const Vector<cell> &cells, Vector<uint8_t> *out)
+{
+  for (size_t i = 0; i < cells.length(); i++) {
+    ucell value = (ucell(cells[i]) << 1) ^ ucell(cells[i] >> (sizeof(cell) * 8 - 1));
+    while (value >= 0x80) {
+      out->append(uint8_t(value | 0x80));
+      value >>= 7;
+    }
+    out->append(uint8_t(value));
+  }
+}
+
+typedef SmxListSection<sp_file_format_t> SmxFormatSection;
+typedef SmxListSection<sp_file_format_spec_t> SmxFormatSpecSection;
+
+// Data addresses of string literals used as native format strings.
+static Vector<cell> FormatStrings;
+
+void mark_format_string(cell address)
+{
+  FormatStrings.append(address);
+}
+
+static int sort_cells(const void *a1, const void *a2)
+{
+  cell c1 = *(const cell *)a1;
+  cell c2 = *(const cell *)a2;
+  return (c1 > c2) - (c1 < c2);
+}
+
+// Splits each recorded format string into its '%' specifiers, so natives
+// need not scan constant formats at run time. A specifier is '%', then any
+// flags, width or precision ("-0123.4"), then the conversion character. The
+// strings are read back out of the final data segment, so the tables always
+// describe exactly what the VM will see.
+static void append_format_tables(SmxBuilder *builder, const Vector<cell> &data_buffer)
+{
+  if (FormatStrings.empty())
+    return;
+
+  RefPtr<SmxFormatSection> formats = new SmxFormatSection(".formats");
+  RefPtr<SmxFormatSpecSection> specs = new SmxFormatSpecSection(".formats.specs");
+
+  const char *data = (const char *)data_buffer.buffer();
+  size_t datasize = data_buffer.length() * sizeof(cell);
+
+  qsort(FormatStrings.buffer(), FormatStrings.length(), sizeof(cell), sort_cells);
+  for (size_t i = 0; i < FormatStrings.length(); i++) {
+    cell address = FormatStrings[i];
+    if (i > 0 && FormatStrings[i - 1] == address)
+      continue;
+    if (address < 0 || size_t(address) >= datasize)
+      continue;
+
+    const char *str = data + address;
+    size_t length = strnlen(str, datasize - address);
+    if (length == datasize - address)
+      continue;
+
+    sp_file_format_t &format = formats->add();
+    format.address = address;
+    format.first_spec = specs->count();
+    for (size_t pos = 0; pos < length; pos++) {
+      if (str[pos] != '%')
+        continue;
+      size_t end = pos + 1;
+      while (end < length && (str[end] == '-' || str[end] == '.' || isdigit((unsigned char)str[end])))
+        end++;
+      if (end == length || end + 1 - pos > 0xffff)
+        break;
+
+      sp_file_format_spec_t &spec = specs->add();
+      spec.offset = pos;
+      spec.length = uint16_t(end + 1 - pos);
+      spec.conversion = (uint8_t)str[end];
+      pos = end;
+    }
+    format.num_specs = specs->count() - format.first_spec;
+  }
+
+  FormatStrings.clear();
+  builder->add(formats);
+  builder->add(specs);
+}
+
 typedef SmxListSection<sp_file_natives_t> SmxNativeSection;
 typedef SmxListSection<sp_file_publics_t> SmxPublicSection;
 typedef SmxListSection<sp_file_pubvars_t> SmxPubvarSection;
 typedef SmxBlobSection<sp_file_data_t> SmxDataSection;
 typedef SmxBlobSection<sp_file_code_t> SmxCodeSection;
 
-static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
+static bool write_binary(const char *binfname, SmxBuilder *builder);
+
+// Builds the SMX image and writes it to |binfname|. Any fatal error raised
+// while assembling happens before the output file is opened, so a failed
+// compile leaves nothing on disk. Returns false if the file could not be
+// written.
+static bool assemble_to_file(const char *binfname, void *fin)
 {
   StringPool pool;
   SmxBuilder builder;
@@ -864,6 +1268,13 @@ static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
 
   // The public list must be sorted.
   qsort(functions.buffer(), functions.length(), sizeof(function_entry), sort_functions);
+  for (size_t i = 0; i < functions.length(); i++)
+    functions[i].sym->funcid = (uint32_t(i) << 1) | 1;
+
+  // Relocate all labels in the assembly buffer. This also decides which calls
+  // are inlined, so it must happen before any code address is written out.
+  relocate_labels(fin);
+
   for (size_t i = 0; i < functions.length(); i++) {
     function_entry &f = functions[i];
     symbol *sym = f.sym;
@@ -873,10 +1284,8 @@ static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
     assert(sym->codeaddr > sym->addr());
 
     sp_file_publics_t &pubfunc = publics->add();
-    pubfunc.address = sym->addr();
+    pubfunc.address = remap_code_address(sym->addr());
     pubfunc.name = names->add(pool, f.name.chars());
-
-    sym->funcid = (uint32_t(i) << 1) | 1;
   }
 
   // Shuffle natives to be in address order.
@@ -894,22 +1303,31 @@ static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
       entry.name = names->add(pool, sym->name);
   }
 
-  // Relocate all labels in the assembly buffer.
-  relocate_labels(fin);
-
   // Generate buffers.
   Vector<cell> code_buffer, data_buffer;
   generate_segment(&code_buffer, fin, sIN_CSEG);
   generate_segment(&data_buffer, fin, sIN_DSEG);
 
+  // The code generator's byte count predates inlining; report what was
+  // actually generated.
+  code_idx = code_buffer.length() * sizeof(cell);
+
   // Set up the code section.
-  code->header().codesize = code_buffer.length() * sizeof(cell);
+  Vector<uint8_t> compact_code;
   code->header().cellsize = sizeof(cell);
-  code->header().codeversion = SmxConsts::CODE_VERSION_JIT_1_1;
   code->header().flags = CODEFLAG_DEBUG;
   code->header().main = 0;
   code->header().code = sizeof(sp_file_code_t);
-  code->setBlob((uint8_t *)code_buffer.buffer(), code_buffer.length() * sizeof(cell));
+  if (sc_compactcode) {
+    encode_compact_code(code_buffer, &compact_code);
+    code->header().codesize = compact_code.length();
+    code->header().codeversion = SmxConsts::CODE_VERSION_SP1_COMPACT;
+    code->setBlob(compact_code.buffer(), compact_code.length());
+  } else {
+    code->header().codesize = code_buffer.length() * sizeof(cell);
+    code->header().codeversion = SmxConsts::CODE_VERSION_JIT_1_1;
+    code->setBlob((uint8_t *)code_buffer.buffer(), code_buffer.length() * sizeof(cell));
+  }
 
   // Set up the data section. Note pre-SourceMod 1.7, the |memsize| was
   // computed as AMX::stp, which included the entire memory size needed to
@@ -925,6 +1343,8 @@ static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
 
   free(LabelTable);
   LabelTable = nullptr;
+  InlineCandidates.clear();
+  AddressShifts.clear();
 
   // Add tables in the same order SourceMod 1.6 added them.
   builder.add(code);
@@ -934,59 +1354,180 @@ static void assemble_to_buffer(MemoryBuffer *buffer, void *fin)
   builder.add(natives);
   builder.add(names);
   append_debug_tables(&builder, pool, names, nativeList);
+  append_format_tables(&builder, data_buffer);
 
-  builder.write(buffer);
+  return write_binary(binfname, &builder);
 }
 
-static void splat_to_binary(const char *binfname, void *bytes, size_t size)
+// Streams an SMX image straight to the output file. Everything up to the
+// header's |dataoffs| (the header, section list, and section names) is
+// written as-is; everything after is fed through deflate in fixed-size
+// chunks, so the image is never buffered in memory as a whole. Once the
+// stream is finished, the header is rewritten with the compressed size.
+class DeflateFileBuffer : public ISmxBuffer
 {
-  // Note: error 161 will setjmp(), which skips destructors :(
-  FILE *fp = fopen(binfname, "wb");
-  if (!fp) {
-    error(FATAL_ERROR_WRITE, binfname);
-    return;
+  static const size_t kChunkSize = 64 * 1024;
+
+ public:
+  DeflateFileBuffer(FILE *fp, bool compress)
+   : fp_(fp),
+     pos_(0),
+     raw_size_(sizeof(sp_file_hdr_t)),
+     compress_(compress),
+     compressing_(false),
+     deflate_failed_(false),
+     failed_(false)
+  {
+    memset(&header_, 0, sizeof(header_));
+    memset(&strm_, 0, sizeof(strm_));
   }
-  if (fwrite(bytes, 1, size, fp) != size) {
-    fclose(fp);
-    error(FATAL_ERROR_WRITE, binfname);
-    return;
+  ~DeflateFileBuffer() {
+    if (compressing_)
+      deflateEnd(&strm_);
   }
-  fclose(fp);
+
+  bool write(const void *bytes, size_t len) override {
+    const uint8_t *ptr = (const uint8_t *)bytes;
+    if (pos_ < raw_size_) {
+      size_t raw = ke::Min(len, raw_size_ - pos_);
+      if (!writeRaw(ptr, raw))
+        return false;
+      ptr += raw;
+      len -= raw;
+    }
+    if (!len)
+      return true;
+    return compressing_ ? deflateChunk(ptr, len, Z_NO_FLUSH) : writeRaw(ptr, len);
+  }
+  size_t pos() const override {
+    return pos_;
+  }
+
+  // Flushes the compressed stream and patches the header. Returns false if
+  // the file could not be written.
+  bool finish() {
+    if (failed_)
+      return false;
+    if (!compressing_)
+      return true;
+    if (!deflateChunk(nullptr, 0, Z_FINISH))
+      return false;
+
+    header_.disksize = header_.dataoffs + strm_.total_out;
+    header_.compression = SmxConsts::FILE_COMPRESSION_GZ;
+    if (fseek(fp_, 0, SEEK_SET) != 0 || fwrite(&header_, sizeof(header_), 1, fp_) != 1)
+      return fail();
+    return true;
+  }
+
+  // True if the file could not be written because deflate failed, rather
+  // than because of an I/O error.
+  bool deflate_failed() const {
+    return deflate_failed_;
+  }
+
+ private:
+  bool writeRaw(const uint8_t *bytes, size_t len) {
+    if (pos_ == 0) {
+      // SmxBuilder always emits the full file header in a single write.
+      assert(len == sizeof(header_));
+      memcpy(&header_, bytes, sizeof(header_));
+      assert(header_.dataoffs >= sizeof(header_));
+      raw_size_ = header_.dataoffs;
+      startCompression();
+    }
+    if (fwrite(bytes, 1, len, fp_) != len)
+      return fail();
+    pos_ += len;
+    return true;
+  }
+
+  void startCompression() {
+    if (!compress_)
+      return;
+    if (deflateInit(&strm_, Z_BEST_COMPRESSION) != Z_OK) {
+      pc_printf("Unable to compress, out of memory\n");
+      pc_printf("Falling back to no compression.\n");
+      return;
+    }
+    compressing_ = true;
+  }
+
+  bool deflateChunk(const uint8_t *bytes, size_t len, int flush) {
+    strm_.next_in = (Bytef *)bytes;
+    strm_.avail_in = (uInt)len;
+    pos_ += len;
+
+    Bytef out[kChunkSize];
+    int err;
+    do {
+      strm_.next_out = out;
+      strm_.avail_out = sizeof(out);
+      err = deflate(&strm_, flush);
+      if (err == Z_STREAM_ERROR) {
+        pc_printf("Unable to compress, error %d\n", err);
+        deflate_failed_ = true;
+        return fail();
+      }
+      size_t produced = sizeof(out) - strm_.avail_out;
+      if (fwrite(out, 1, produced, fp_) != produced)
+        return fail();
+    } while (strm_.avail_out == 0 || (flush == Z_FINISH && err != Z_STREAM_END));
+    assert(strm_.avail_in == 0);
+    return true;
+  }
+
+  bool fail() {
+    failed_ = true;
+    return false;
+  }
+
+ private:
+  FILE *fp_;
+  sp_file_hdr_t header_;
+  z_stream strm_;
+  size_t pos_;
+  size_t raw_size_;
+  bool compress_;
+  bool compressing_;
+  bool deflate_failed_;
+  bool failed_;
+};
+
+static bool write_binary_file(const char *binfname, SmxBuilder *builder, bool compress,
+                              bool *deflate_failed)
+{
+  FILE *fp = fopen(binfname, "wb");
+  if (!fp)
+    return false;
+
+  DeflateFileBuffer buffer(fp, compress);
+  bool ok = builder->write(&buffer) && buffer.finish();
+  *deflate_failed = buffer.deflate_failed();
+
+  if (fclose(fp) != 0)
+    ok = false;
+  return ok;
 }
 
-void assemble(const char *binfname, void *fin)
+static bool write_binary(const char *binfname, SmxBuilder *builder)
 {
-  MemoryBuffer buffer;
-  assemble_to_buffer(&buffer, fin);
-
-  // Buffer compression logic. 
-  sp_file_hdr_t *header = (sp_file_hdr_t *)buffer.bytes();
-  size_t region_size = header->imagesize - header->dataoffs;
-  size_t zbuf_max = compressBound(region_size);
-  Bytef *zbuf = (Bytef *)malloc(zbuf_max);
-
-  uLong new_disksize = zbuf_max;
-  int err = compress2(
-    zbuf, 
-    &new_disksize,
-    (Bytef *)(buffer.bytes() + header->dataoffs),
-    region_size,
-    Z_BEST_COMPRESSION
-  );
-  if (err != Z_OK) {
-    free(zbuf);
-    pc_printf("Unable to compress, error %d\n", err);
+  bool deflate_failed = false;
+  bool ok = write_binary_file(binfname, builder, true, &deflate_failed);
+  if (!ok && deflate_failed) {
     pc_printf("Falling back to no compression.\n");
-    splat_to_binary(binfname, buffer.bytes(), buffer.size());
-    return;
+    ok = write_binary_file(binfname, builder, false, &deflate_failed);
   }
+  if (!ok) {
+    // Don't leave a truncated image behind for other tools to load.
+    remove(binfname);
+  }
+  return ok;
+}
 
-  header->disksize = new_disksize + header->dataoffs;
-  header->compression = SmxConsts::FILE_COMPRESSION_GZ;
-
-  buffer.rewind(header->dataoffs);
-  buffer.write(zbuf, new_disksize);
-  free(zbuf);
-
-  splat_to_binary(binfname, buffer.bytes(), buffer.size());
+void assemble(const char *binfname, void *fin)
+{
+  // Note: error 161 will setjmp(), which skips destructors :(
+  if (!assemble_to_file(binfname, fin))
+    error(FATAL_ERROR_WRITE, binfname);
 }
@@ -46,6 +46,7 @@ char *inpfname;                  /* pointer to name of the file currently read f
 char outfname[_MAX_PATH];        /* intermediate (assembler) file name */
 char binfname[_MAX_PATH];        /* binary file name */
 char errfname[_MAX_PATH];        /* error file name */
+char proffname[_MAX_PATH];       /* method profile written by the VM, if any */
 char sc_ctrlchar = CTRL_CHAR;    /* the control character (or escape character)*/
 char sc_ctrlchar_org = CTRL_CHAR;/* the default control character */
 int litidx    = 0;               /* index to literal table */
@@ -63,6 +64,8 @@ int sc_debug  = sCHKBOUNDS; /* by default: bounds checking+assertions */
 int sc_packstr= FALSE;  /* strings are packed by default? */
 int sc_asmfile= FALSE;  /* create .ASM file? */
 int sc_listing= FALSE;  /* create .LST file? */
+int sc_compactcode=FALSE; /* emit varint-encoded code? */
+int sc_flatarrays=FALSE;  /* index fixed 2-D arrays without the indirection vector? */
 int sc_needsemicolon=TRUE;/* semicolon required to terminate expressions? */
 int sc_dataalign=sizeof(cell);/* data alignment value */
 int pc_docexpr=FALSE;   /* must expression be attached to documentation comment? */
@@ -10,7 +10,12 @@ typedef struct {
 typedef struct {
   int id;
   int value;
-  char str[sLINEMAX + 1];
+  // Points at |name| for symbols and labels. String literals are copied into
+  // the literal queue as soon as they are lexed, so their text goes to one
+  // scratch buffer shared by all tokens instead of a line-sized buffer in
+  // each of them.
+  char *str;
+  char name[sNAMEMAX + 1];
   size_t len;
   token_pos_t start;
   token_pos_t end;
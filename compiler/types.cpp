@@ -59,16 +59,16 @@ Type::resetPtr()
 
 TypeDictionary::TypeDictionary()
 {
+  names_.init(256);
 }
 
 Type*
 TypeDictionary::find(const char* name)
 {
-  for (const auto& type : types_) {
-    if (strcmp(type->name(), name) == 0)
-      return type.get();
-  }
-  return nullptr;
+  NameMap::Result r = names_.find(name);
+  if (!r.found())
+    return nullptr;
+  return r->value;
 }
 
 Type*
@@ -82,20 +82,22 @@ TypeDictionary::find(int tag)
 Type*
 TypeDictionary::findOrAdd(const char* name)
 {
-  for (const auto& type : types_) {
-    if (strcmp(type->name(), name) == 0)
-      return type.get();
-  }
+  NameMap::Insert p = names_.findForAdd(name);
+  if (p.found())
+    return p->value;
 
   int tag = int(types_.length());
   UniquePtr<Type> type = MakeUnique<Type>(name, tag);
+  Type* ptr = type.get();
   types_.append(Move(type));
-  return types_.back().get();
+  names_.add(p, ptr->name(), ptr);
+  return ptr;
 }
 
 void
 TypeDictionary::clear()
 {
+  names_.clear();
   types_.clear();
 }
 
@@ -26,6 +26,8 @@
 #ifndef _INCLUDE_SOURCEPAWN_COMPILER_TYPES_H_
 #define _INCLUDE_SOURCEPAWN_COMPILER_TYPES_H_
 
+#include <string.h>
+#include <amtl/am-hashmap.h>
 #include <amtl/am-string.h>
 #include <amtl/am-uniqueptr.h>
 #include <amtl/am-vector.h>
@@ -205,7 +207,20 @@ private:
   Type* findOrAdd(const char* name);
 
 private:
+  struct NamePolicy {
+    static uint32_t hash(const char* key) {
+      return ke::HashCharSequence(key, strlen(key));
+    }
+    static bool matches(const char* key, const char* name) {
+      return strcmp(key, name) == 0;
+    }
+  };
+  typedef ke::HashMap<const char*, Type*, NamePolicy> NameMap;
+
+  // Types are indexed by tag id; |names_| maps each type's own name buffer
+  // back to it, so lookups by name do not scan every tag.
   ke::Vector<ke::UniquePtr<Type>> types_;
+  NameMap names_;
 };
 
 extern TypeDictionary gTypes;
@@ -65,17 +65,35 @@ GetMessageInfo(rmsg::Id id)
 }
 
 void
-TMessage::addArg(Type *type)
+TMessage::addString(const char *str, size_t length)
 {
-  addArg(BuildTypeName(type));
+  Arg arg = Arg::FromString(strings_.length());
+  for (size_t i = 0; i < length; i++)
+    strings_.append(str[i]);
+  strings_.append('\0');
+  args_.append(arg);
 }
 
-void
-TMessage::addArg(size_t value)
+AString
+TMessage::Arg::Render(const char *strings) const
 {
-  char buffer[24];
-  SafeSprintf(buffer, sizeof(buffer), "%" KE_FMT_SIZET, value);
-  addArg(buffer);
+  switch (kind_) {
+    case Kind::String:
+      return AString(strings + offset_);
+    case Kind::Atom:
+      return AString(atom_->chars());
+    case Kind::Integer:
+    {
+      char buffer[24];
+      SafeSprintf(buffer, sizeof(buffer), "%" KE_FMT_SIZET, integer_);
+      return AString(buffer);
+    }
+    case Kind::Type:
+      return BuildTypeName(type_);
+    default:
+      assert(false);
+      return AString();
+  }
 }
 
 ReportManager::ReportManager()
@@ -289,7 +307,8 @@ ReportManager::printSourceLine(const FullSourceRef &ref)
 }
 
 AString
-ReportManager::renderMessage(rmsg::Id id, const AutoPtr<TMessage::Arg> *args, size_t argc)
+ReportManager::renderMessage(rmsg::Id id, const TMessage::Arg *args, size_t argc,
+                             const char *strings)
 {
   const rmsg_info &info = GetMessageInfo(id);
 
@@ -307,7 +326,7 @@ ReportManager::renderMessage(rmsg::Id id, const AutoPtr<TMessage::Arg> *args, si
       }
 
       builder = builder + AString(info.text + last_insertion, i - last_insertion);
-      builder = builder + args[argno]->Render();
+      builder = builder + args[argno].Render(strings);
 
       last_insertion = i + 2;
     }
@@ -343,7 +362,8 @@ ReportManager::printMessage(RefPtr<TMessage> message)
   line = line + ": ";
   line = line + renderMessage(message->id(),
                               message->args().buffer(),
-                              message->args().length());
+                              message->args().length(),
+                              message->strings());
 
   fprintf(stderr, "%s\n", line.ptr());
 
@@ -356,7 +376,7 @@ ReportManager::printMessage(RefPtr<TMessage> message)
     note = note + ": ";
 
     Atom *name = history.macros[i].macro->name;
-    AutoPtr<TMessage::Arg> arg(new TMessage::AtomArg(name));
+    TMessage::Arg arg(name);
 
     note = note + renderMessage(rmsg::from_macro, &arg, 1);
 
@@ -375,9 +395,3 @@ ReportManager::printMessage(RefPtr<TMessage> message)
   for (size_t i = 0; i < message->num_notes(); i++)
     printMessage(message->note(i));
 }
-
-AString
-TMessage::AtomArg::Render()
-{
-  return AString(atom_->chars());
-}
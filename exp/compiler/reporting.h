@@ -59,64 +59,72 @@ class TMessage : public ke::Refcounted<TMessage>
      message_id_(msgid)
   {}
 
+  // Arguments are stored inline and are only rendered if the message is
+  // actually printed. Strings are copied into a buffer owned by the message,
+  // since callers may pass temporaries.
   class Arg
   {
    public:
-    virtual ~Arg() {}
-    virtual AString Render() = 0;
-  };
-
-  class StringArg : public Arg
-  {
-   public:
-    explicit StringArg(const char *str)
-     : str_(str)
-    {}
-    explicit StringArg(const AString &str)
-     : str_(str)
-    {}
-    explicit StringArg(AString &&str)
-     : str_(str)
-    {}
-
-    AString Render() override {
-      return str_;
+    enum class Kind : uint8_t {
+      String,
+      Atom,
+      Integer,
+      Type
+    };
+
+    static Arg FromString(size_t offset) {
+      Arg arg(Kind::String);
+      arg.offset_ = offset;
+      return arg;
+    }
+    explicit Arg(Atom *atom)
+     : kind_(Kind::Atom)
+    {
+      atom_ = atom;
+    }
+    explicit Arg(size_t value)
+     : kind_(Kind::Integer)
+    {
+      integer_ = value;
+    }
+    explicit Arg(Type *type)
+     : kind_(Kind::Type)
+    {
+      type_ = type;
     }
 
-   private:
-    AString str_;
-  };
+    AString Render(const char *strings) const;
 
-  class AtomArg : public Arg
-  {
-   public:
-    explicit AtomArg(Atom *atom)
-     : atom_(atom)
+   private:
+    explicit Arg(Kind kind)
+     : kind_(kind)
     {}
 
-    AString Render() override;
-
    private:
-    Atom *atom_;
+    Kind kind_;
+    union {
+      size_t offset_;
+      Atom *atom_;
+      size_t integer_;
+      Type *type_;
+    };
   };
 
-  void addArg(Arg *arg) {
-    args_.append(arg);
-  }
   void addArg(Atom *atom) {
-    addArg(new AtomArg(atom));
+    args_.append(Arg(atom));
   }
   void addArg(const char *str) {
-    addArg(new StringArg(str));
+    addString(str, strlen(str));
   }
   void addArg(const AString &str) {
-    addArg(new StringArg(str));
+    addString(str.chars(), str.length());
+  }
+  void addArg(size_t value) {
+    args_.append(Arg(value));
   }
-  void addArg(AString &&str) {
-    addArg(new StringArg(str));
+  void addArg(Type *type) {
+    args_.append(Arg(type));
   }
-  void addArg(size_t value);
-  void addArg(Type *type);
 
   void addNote(RefPtr<TMessage> note) {
     if (note) {
@@ -137,14 +145,21 @@ class TMessage : public ke::Refcounted<TMessage>
   RefPtr<TMessage> note(size_t i) const {
     return notes_[i];
   }
-  const Vector<AutoPtr<Arg>> &args() const {
+  const Vector<Arg> &args() const {
     return args_;
   }
+  const char *strings() const {
+    return strings_.buffer();
+  }
+
+ private:
+  void addString(const char *str, size_t length);
 
  private:
   SourceLocation origin_;
   rmsg::Id message_id_;
-  Vector<AutoPtr<Arg>> args_;
+  Vector<Arg> args_;
+  Vector<char> strings_;
   Vector<RefPtr<TMessage>> notes_;
 };
 
@@ -232,8 +247,9 @@ class ReportManager
 
   AString renderSourceRef(const FullSourceRef &ref);
   AString renderMessage(rmsg::Id id,
-                        const AutoPtr<TMessage::Arg> *args,
-                        size_t len);
+                        const TMessage::Arg *args,
+                        size_t len,
+                        const char *strings = nullptr);
 
  private:
   SourceManager *source_;
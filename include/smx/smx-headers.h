@@ -67,6 +67,11 @@ struct SmxConsts
   static const uint8_t CODE_VERSION_SP1_MIN = CODE_VERSION_JIT_1_0;
   static const uint8_t CODE_VERSION_SP1_MAX = CODE_VERSION_JIT_1_1;
 
+  // SourcePawn 1.1 code, with every cell stored as a zigzag LEB128 varint.
+  // Loaders expand it back to cells; all code addresses in the file refer
+  // to the expanded stream.
+  static const uint8_t CODE_VERSION_SP1_COMPACT = 12;
+
   // For SP1 consumers, the container version may not be checked, but usually
   // the code version is. This constant allows newer containers to be rejected
   // in those applications.
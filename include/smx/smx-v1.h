@@ -80,6 +80,24 @@ typedef struct sp_file_tag_s
   uint32_t  name;     /**< Index into nametable */
 } sp_file_tag_t;
 
+// The ".formats" section lists constant format strings, sorted by address.
+// Each one owns a run of entries in the ".formats.specs" section.
+typedef struct sp_file_format_s
+{
+  uint32_t  address;    /**< Address of the string relative to the DAT section */
+  uint32_t  first_spec; /**< Index of the first entry in .formats.specs */
+  uint32_t  num_specs;  /**< Number of specifiers in the string */
+} sp_file_format_t;
+
+// The ".formats.specs" section. Layout matches sp_format_spec_t.
+typedef struct sp_file_format_spec_s
+{
+  uint32_t  offset;     /**< Byte offset of the '%' in the string */
+  uint16_t  length;     /**< Length of the specifier, including the '%' */
+  uint8_t   conversion; /**< Conversion character ('%' for a literal percent) */
+  uint8_t   reserved;   /**< Must be 0 */
+} sp_file_format_spec_t;
+
 // The ".dbg.info" section.
 typedef struct sp_fdbg_info_s
 {
@@ -23,8 +23,8 @@
 #include "sp_vm_types.h"
 
 /** SourcePawn Engine API Versions */
-#define SOURCEPAWN_ENGINE2_API_VERSION 0xC
-#define SOURCEPAWN_API_VERSION   0x020D
+#define SOURCEPAWN_ENGINE2_API_VERSION 0xD
+#define SOURCEPAWN_API_VERSION   0x0210
 
 namespace SourceMod {
   struct IdentityToken_t;
@@ -473,7 +473,7 @@ namespace SourcePawn
      * @brief Update the native binding at the given index.
      *
      * @param pfn       Native function pointer.
-     * @param flags     Native flags.
+     * @param flags     Native flags. SP_NTVFLAG_VECTOR is ignored.
      * @param user      User data pointer.
      */
     virtual int UpdateNativeBinding(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_t flags, void *data) = 0;
@@ -490,6 +490,50 @@ namespace SourcePawn
      * @brief Return the file or location this plugin was loaded from.
      */
     virtual const char *GetFilename() = 0;
+
+    /**
+     * @brief Bind the native at the given index to a vector callback. The
+     * plugin must declare the native as:
+     *
+     *   native void Name(const any[] args, any[] results, int count);
+     *
+     * where |args| holds |count| tuples of |arity| cells. The whole batch
+     * is passed to |pfn| in a single native call, so per-element queries
+     * (for example, one per client) cost one transition instead of |count|.
+     *
+     * @param index     Native index.
+     * @param pfn       Vector callback.
+     * @param arity     Number of cells in each argument tuple.
+     * @param flags     Native flags. SP_NTVFLAG_VECTOR is always added, and
+     *                  SP_NTVFLAG_INTRINSIC is ignored.
+     * @param data      User data pointer, passed to |pfn|.
+     * @return          Error code.
+     */
+    virtual int UpdateVectorNativeBinding(uint32_t index, SPVM_VECTOR_NATIVE_FUNC pfn,
+                                          uint32_t arity, uint32_t flags, void *data) = 0;
+
+    /**
+     * @brief Enables or disables latency recording for host calls into this
+     * plugin's public functions. Recording costs one pair of timestamps per
+     * call. Disabling keeps the statistics gathered so far.
+     *
+     * @param enabled   True to record, false to stop.
+     */
+    virtual void SetLatencyTracking(bool enabled) = 0;
+
+    /**
+     * @brief Returns the latency histogram of a public function.
+     *
+     * @param index     Public function index.
+     * @param stats     Filled with the histogram; zeroed if nothing was recorded.
+     * @return          Error code.
+     */
+    virtual int GetPublicLatency(uint32_t index, sp_latency_stats_t *stats) = 0;
+
+    /**
+     * @brief Clears the latency histograms of all public functions.
+     */
+    virtual void ResetLatencyStats() = 0;
   };
 
   
@@ -1063,6 +1107,20 @@ namespace SourcePawn
      */
     virtual void DestroyFrameIterator(IFrameIterator *it) = 0;
 
+    /**
+     * @brief Returns the specifiers of a format string, if the compiler
+     * pre-parsed it. Only string literals passed as the format argument of
+     * a native (a const string parameter followed by variadic arguments)
+     * are pre-parsed. Natives may use this to skip scanning for '%'.
+     *
+     * @param local_addr   Local address of the format string.
+     * @param specs        Set to the specifiers, in string order.
+     * @param count        Set to the number of specifiers.
+     * @return             True if found, false if the string must be parsed.
+     */
+    virtual bool GetFormatSpecs(cell_t local_addr, const sp_format_spec_t **specs,
+                                uint32_t *count) = 0;
+
   };
 
   /**
@@ -1514,6 +1572,24 @@ namespace SourcePawn
      * @brief Returns the environment.
      */
     virtual ISourcePawnEnvironment *Environment() = 0;
+
+    /**
+     * @brief Sets how many times a function must be invoked from the host
+     * before it is JIT-compiled. Until then it runs in the interpreter, along
+     * with everything it calls. The default of 1 compiles on first use; a
+     * higher value keeps rarely called callbacks out of the JIT, at the cost
+     * of interpreting the first calls of every function.
+     *
+     * @param threshold  Number of host invocations (0 is treated as 1).
+     */
+    virtual void SetJitThreshold(uint32_t threshold) = 0;
+
+    /**
+     * @brief Returns the JIT threshold set by SetJitThreshold().
+     *
+     * @return      Number of host invocations before a function is compiled.
+     */
+    virtual uint32_t GetJitThreshold() = 0;
   };
 
   // @brief This class is the v3 API for SourcePawn. It provides access to
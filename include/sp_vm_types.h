@@ -125,6 +125,15 @@ typedef cell_t (*SPVM_NATIVE_FUNC)(SourcePawn::IPluginContext *, const cell_t *)
  */
 typedef cell_t (*SPVM_FAKENATIVE_FUNC)(SourcePawn::IPluginContext *, const cell_t *, void *);
 
+/**
+ * @brief Vector native callback prototype, passed a context, |count| argument tuples
+ * of |arity| cells each (stored back to back), a buffer for one result per tuple, and
+ * private data. SP_ERROR_NONE must be returned on success.
+ */
+typedef int (*SPVM_VECTOR_NATIVE_FUNC)(SourcePawn::IPluginContext *, const cell_t *args,
+                                       uint32_t arity, uint32_t count, cell_t *results,
+                                       void *data);
+
 /**********************************************
  *** The following structures are bound to the VM/JIT.
  *** Changing them will result in necessary recompilation.
@@ -156,6 +165,8 @@ typedef struct sp_pubvar_s
 
 #define SP_NTVFLAG_OPTIONAL		(1<<0)	/**< Native is optional */
 #define SP_NTVFLAG_EPHEMERAL		(1<<1)	/**< Native can be unbound */
+#define SP_NTVFLAG_VECTOR		(1<<2)	/**< Native is bound to a vector callback */
+#define SP_NTVFLAG_INTRINSIC		(1<<3)	/**< Native may run as the VM intrinsic of the same name */
 
 /** 
  * @brief Information about a native entry in a plugin.
@@ -186,6 +197,58 @@ struct sp_native_t
 	void *				user;
 };
 
+/**
+ * @brief One specifier of a constant format string, pre-parsed by the compiler.
+ */
+typedef struct sp_format_spec_s
+{
+	uint32_t	offset;		/**< Byte offset of the '%' in the string */
+	uint16_t	length;		/**< Length of the specifier, including the '%' */
+	uint8_t		conversion;	/**< Conversion character ('%' for a literal percent) */
+	uint8_t		reserved;	/**< Unused */
+} sp_format_spec_t;
+
+#define SP_LATENCY_BUCKETS		32		/**< Number of buckets in sp_latency_stats_t */
+
+/**
+ * @brief Latency histogram for host calls into one public function. Bucket
+ * i counts calls that took [2^i, 2^(i+1)) nanoseconds; bucket 0 also counts
+ * calls under one nanosecond, and the last bucket counts everything longer.
+ */
+typedef struct sp_latency_stats_s
+{
+	uint64_t	calls;					/**< Number of calls recorded */
+	uint64_t	total_ns;				/**< Sum of all call times */
+	uint64_t	max_ns;					/**< Longest call */
+	uint64_t	buckets[SP_LATENCY_BUCKETS];	/**< Call counts by log2(ns) */
+} sp_latency_stats_t;
+
+/**
+ * @brief Returns an upper bound, in nanoseconds, on the time taken by the
+ * given fraction of recorded calls; for example, 0.99 for the p99 latency.
+ */
+static inline uint64_t sp_latency_percentile(const sp_latency_stats_t *stats, double fraction)
+{
+	if (!stats->calls)
+		return 0;
+
+	uint64_t rank = (uint64_t)(fraction * (double)stats->calls);
+	if (rank < 1)
+		rank = 1;
+
+	uint64_t seen = 0;
+	for (unsigned i = 0; i < SP_LATENCY_BUCKETS - 1; i++)
+	{
+		seen += stats->buckets[i];
+		if (seen >= rank)
+		{
+			uint64_t bound = (uint64_t)2 << i;
+			return (bound < stats->max_ns) ? bound : stats->max_ns;
+		}
+	}
+	return stats->max_ns;
+}
+
 /** 
  * @brief Used for setting natives from modules/host apps.
  */
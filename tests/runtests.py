@@ -1,6 +1,7 @@
 # vim: set ts=2 sw=2 tw=99 et:
 import re
 import os, sys
+import shlex
 import argparse
 import subprocess
 import tempfile
@@ -46,6 +47,8 @@ class ChangeFolder(object):
 class Test(object):
   ManifestKeys = set([
     'returnCode',
+    'compilerFlags',
+    'shellEnv',
   ])
 
   def __init__(self, name, path):
@@ -81,6 +84,21 @@ class Test(object):
       return int(self.manifest['returnCode'])
     return 0
 
+  @property
+  def compilerFlags(self):
+    if 'compilerFlags' in self.manifest:
+      return shlex.split(self.manifest['compilerFlags'])
+    return []
+
+  @property
+  def shellEnv(self):
+    env = os.environ.copy()
+    if 'shellEnv' in self.manifest:
+      for pair in shlex.split(self.manifest['shellEnv']):
+        key, value = pair.split('=', 1)
+        env[key] = value
+    return env
+
 class TestRunner(object):
   def __init__(self, args, tempFolder):
     super(TestRunner, self).__init__()
@@ -171,6 +189,7 @@ class TestRunner(object):
       argv = ['node'] + argv
     if self.args.disable_phopt:
       argv += ['-O0']
+    argv += test.compilerFlags
     argv += [
       test_path,
     ]
@@ -205,7 +224,8 @@ class TestRunner(object):
     ]
     if os.path.splitext(self.shell)[1] == '.js':
       argv = ['node'] + argv
-    p = subprocess.Popen(argv, stdout = subprocess.PIPE, stderr = subprocess.PIPE)
+    p = subprocess.Popen(argv, stdout = subprocess.PIPE, stderr = subprocess.PIPE,
+                         env = test.shellEnv)
     stdout, stderr = p.communicate()
     stdout = stdout.decode('utf-8')
     stderr = stderr.decode('utf-8')
@@ -245,7 +245,7 @@ SourcePawnEngine2::LoadBinaryFromFile(const char *file, char *error, size_t maxl
     return nullptr;
   }
 
-  ke::AutoPtr<SmxV1Image> image(new SmxV1Image(fp));
+  ke::AutoPtr<SmxV1Image> image(new SmxV1Image(fp, Environment::get()->atoms()));
   fclose(fp);
 
   if (!image->validate()) {
@@ -434,3 +434,15 @@ SourcePawnEngine2::Environment()
 {
   return Environment::get();
 }
+
+void
+SourcePawnEngine2::SetJitThreshold(uint32_t threshold)
+{
+  Environment::get()->SetJitThreshold(threshold);
+}
+
+uint32_t
+SourcePawnEngine2::GetJitThreshold()
+{
+  return Environment::get()->JitThreshold();
+}
@@ -69,6 +69,8 @@ class SourcePawnEngine2 : public ISourcePawnEngine2
   void SetProfilingTool(IProfilingTool *tool) override;
   IPluginRuntime *LoadBinaryFromFile(const char *file, char *error, size_t maxlength) override;
   ISourcePawnEnvironment *Environment() override;
+  void SetJitThreshold(uint32_t threshold) override;
+  uint32_t GetJitThreshold() override;
 
  private:
   char engine_name_[256];
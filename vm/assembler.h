@@ -101,13 +101,32 @@ class AssemblerBase
   bool ensureSpace() {
     if (pos_ + kMaxInstructionSize <= end_)
       return true;
+    return grow(size_t(pos_ - buffer_) + kMaxInstructionSize);
+  }
 
+ public:
+  // Grow the buffer up front so that at least |bytes| more bytes can be
+  // emitted without reallocating. This is only a hint; ensureSpace() still
+  // guards every instruction.
+  bool reserve(size_t bytes) {
+    if (bytes <= size_t(end_ - pos_))
+      return true;
+    if (bytes > kMaxBufferSize)
+      return true;
+    return grow(size_t(pos_ - buffer_) + bytes);
+  }
+
+ protected:
+  bool grow(size_t minimum) {
     if (outOfMemory())
       return false;
 
     size_t oldlength = size_t(end_ - buffer_);
+    size_t newlength = oldlength;
+    while (newlength < minimum && newlength <= kMaxBufferSize)
+      newlength *= 2;
 
-    if (oldlength * 2 > kMaxBufferSize) {
+    if (newlength > kMaxBufferSize) {
       // See comment when if realloc() fails.
       pos_ = buffer_;
       outOfMemory_ = true;
@@ -115,7 +134,7 @@ class AssemblerBase
     }
 
     size_t oldpos = size_t(pos_ - buffer_);
-    uint8_t *newbuf = (uint8_t *)realloc(buffer_, oldlength * 2);
+    uint8_t *newbuf = (uint8_t *)realloc(buffer_, newlength);
     if (!newbuf) {
       // Writes will be safe, though we'll corrupt the instruction stream, so
       // actually using the buffer will be invalid and compilation should be
@@ -125,7 +144,7 @@ class AssemblerBase
       return false;
     }
     buffer_ = newbuf;
-    end_ = newbuf + oldlength * 2;
+    end_ = newbuf + newlength;
     pos_ = buffer_ + oldpos;
     return true;
   }
@@ -0,0 +1,104 @@
+// vim: set ts=8 sts=2 sw=2 tw=99 et:
+//
+// This file is part of SourcePawn.
+// 
+// SourcePawn is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// SourcePawn is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with SourcePawn.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef _include_sourcepawn_vm_atom_table_h_
+#define _include_sourcepawn_vm_atom_table_h_
+
+#include <stdlib.h>
+#include <string.h>
+#include <am-hashtable.h>
+#include <am-thread-utils.h>
+
+namespace sp {
+
+using namespace ke;
+
+// Environment-wide table of interned names. Every plugin refers to natives
+// and publics like "OnPluginStart" by the same canonical string, so names can
+// be compared and hashed by pointer once both sides are atoms. This is a
+// lookup index, not a memory saving: images still keep their own .names
+// section, and atoms live (and are never freed) as long as the environment.
+//
+// Images are loaded and queried from any thread, so the table has its own
+// lock. It is only taken by image loads and by-name lookups, never on a call
+// path, so it is short-lived and normally uncontended.
+class AtomTable
+{
+ public:
+  AtomTable()
+   : table_(SystemAllocatorPolicy())
+  {
+    table_.init(256);
+  }
+
+  ~AtomTable()
+  {
+    if (!table_.elements())
+      return;
+    for (Table::iterator i(&table_); !i.empty(); i.next())
+      free(const_cast<char *>(*i));
+  }
+
+  // Return the atom for |str|, adding it if needed. Returns null on OOM.
+  const char *add(const char *str) {
+    ke::AutoLock lock(&lock_);
+    Table::Insert p = table_.findForAdd(str);
+    if (p.found())
+      return *p;
+
+    size_t length = strlen(str);
+    char *atom = (char *)malloc(length + 1);
+    if (!atom)
+      return nullptr;
+    memcpy(atom, str, length + 1);
+
+    if (!table_.add(p, atom)) {
+      free(atom);
+      return nullptr;
+    }
+    return atom;
+  }
+
+  // Return the atom for |str|, or null if no image has ever used this name.
+  const char *find(const char *str) {
+    ke::AutoLock lock(&lock_);
+    Table::Result r = table_.find(str);
+    if (!r.found())
+      return nullptr;
+    return *r;
+  }
+
+ private:
+  struct Policy {
+    typedef const char *Payload;
+
+    static uint32_t hash(const char *key) {
+      return HashCharSequence(key, strlen(key));
+    }
+    static bool matches(const char *key, const Payload &e) {
+      return strcmp(key, e) == 0;
+    }
+  };
+  typedef HashTable<Policy> Table;
+
+ private:
+  ke::Mutex lock_;
+  Table table_;
+};
+
+} // namespace sp
+
+#endif // _include_sourcepawn_vm_atom_table_h_
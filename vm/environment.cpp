@@ -28,6 +28,10 @@ using namespace SourcePawn;
 
 static Environment *sEnvironment = nullptr;
 
+// By default every method is compiled on its first entry from the host;
+// embedders can opt into interpreting cold entry points with SetJitThreshold().
+static const uint32_t kDefaultJitThreshold = 1;
+
 Environment::Environment()
  : debugger_(nullptr),
    eh_top_(nullptr),
@@ -38,7 +42,11 @@ Environment::Environment()
 #else
    jit_enabled_(false),
 #endif
+   jit_threshold_(kDefaultJitThreshold),
    profiling_enabled_(false),
+   method_counters_enabled_(false),
+   opcode_counters_enabled_(false),
+   jit_dump_enabled_(false),
    top_(nullptr)
 {
 }
@@ -258,6 +266,10 @@ Environment::Invoke(PluginContext* cx,
 {
 #if defined(SP_HAS_JIT)
   if (jit_enabled_) {
+    // Cold methods are interpreted; see SetJitThreshold().
+    if (!method->jit() && method->countHostInvocation() < jit_threshold_)
+      return Interpreter::Run(cx, method, result);
+
     if (!method->jit()) {
       int err = SP_ERROR_NONE;
       if (!CompilerBase::Compile(cx, method, &err)) {
@@ -17,6 +17,7 @@
 #include <amtl/am-cxx.h>
 #include <amtl/am-inlinelist.h>
 #include <amtl/am-thread-utils.h>
+#include "atom-table.h"
 #include "code-allocator.h"
 #include "plugin-runtime.h"
 #include "stack-frames.h"
@@ -105,6 +106,48 @@ class Environment : public ISourcePawnEnvironment
   bool IsJitEnabled() const {
     return jit_enabled_;
   }
+
+  // Number of times a method must be invoked from the host before it is
+  // compiled; until then it runs in the interpreter, along with everything it
+  // calls. The default of 1 compiles on first use. Raising it keeps rarely
+  // called entry points out of the JIT, but also runs the first calls of
+  // heavy one-shot callbacks interpreted, so it is opt-in.
+  void SetJitThreshold(uint32_t threshold) {
+    jit_threshold_ = threshold ? threshold : 1;
+  }
+  uint32_t JitThreshold() const {
+    return jit_threshold_;
+  }
+
+  // When enabled, every method counts how many times it is entered. This
+  // must be set before any code is compiled, since the JIT bakes the counter
+  // into method prologues.
+  void SetMethodCountersEnabled(bool enabled) {
+    method_counters_enabled_ = enabled;
+  }
+  bool MethodCountersEnabled() const {
+    return method_counters_enabled_;
+  }
+
+  // When enabled, every opcode executed is counted per plugin, along with
+  // pairs of consecutive opcodes (interpreter only) and native calls. Like
+  // method counters, this must be set before any code is compiled.
+  void SetOpcodeCountersEnabled(bool enabled) {
+    opcode_counters_enabled_ = enabled;
+  }
+  bool OpcodeCountersEnabled() const {
+    return opcode_counters_enabled_;
+  }
+
+  // When enabled, the JIT prints each method it compiles to stdout: the pcode
+  // with source lines, the machine code emitted for every opcode, and a
+  // summary of code size per opcode.
+  void SetJitDumpEnabled(bool enabled) {
+    jit_dump_enabled_ = enabled;
+  }
+  bool JitDumpEnabled() const {
+    return jit_dump_enabled_;
+  }
   void SetDebugger(IDebugListener *debugger) {
     debugger_ = debugger;
   }
@@ -112,6 +155,10 @@ class Environment : public ISourcePawnEnvironment
     return debugger_;
   }
 
+  AtomTable *atoms() {
+    return &atoms_;
+  }
+
   WatchdogTimer *watchdog() const {
     return watchdog_timer_;
   }
@@ -164,6 +211,9 @@ class Environment : public ISourcePawnEnvironment
   ke::AutoPtr<WatchdogTimer> watchdog_timer_;
   ke::Mutex mutex_;
 
+  // Declared early so that atoms outlive anything that refers to them.
+  AtomTable atoms_;
+
   IDebugListener *debugger_;
   ExceptionHandler *eh_top_;
   int exception_code_;
@@ -171,7 +221,11 @@ class Environment : public ISourcePawnEnvironment
 
   IProfilingTool *profiler_;
   bool jit_enabled_;
+  uint32_t jit_threshold_;
   bool profiling_enabled_;
+  bool method_counters_enabled_;
+  bool opcode_counters_enabled_;
+  bool jit_dump_enabled_;
 
   ke::AutoPtr<CodeAllocator> code_alloc_;
   ke::AutoPtr<CodeStubs> code_stubs_;
@@ -60,14 +60,35 @@ Interpreter::run()
   InterpInvokeFrame ivk(cx_, method_, reader_.cip());
   ke::SaveAndSet<InterpInvokeFrame*> enterIvk(&ivk_, &ivk);
 
+  if (env_->MethodCountersEnabled())
+    method_->countInvocation();
+
   reader_.begin();
 
   if (!cx_->pushAmxFrame())
     return false;
 
+  // Counting is decided once per call, so the normal loop pays nothing.
+  if (env_->OpcodeCountersEnabled())
+    return interpret<true>(rt_->opcode_counters());
+  return interpret<false>(nullptr);
+}
+
+template <bool kCountOpcodes>
+bool
+Interpreter::interpret(OpcodeCounters* counters)
+{
+  OPCODE prev = OP_NONE;
   while (!has_returned_ && reader_.more()) {
-    if (reader_.peekOpcode() == OP_PROC || reader_.peekOpcode() == OP_ENDPROC)
+    OPCODE op = reader_.peekOpcode();
+    if (op == OP_PROC || op == OP_ENDPROC)
       break;
+    if (kCountOpcodes) {
+      counters->ops[op]++;
+      if (prev != OP_NONE)
+        counters->pairs[prev][op]++;
+      prev = op;
+    }
     if (!reader_.visitNext())
       return false;
   }
@@ -80,6 +101,24 @@ Interpreter::invokeNative(uint32_t native_index)
 {
   NativeEntry* native = rt_->NativeAt(native_index);
 
+  if (env_->OpcodeCountersEnabled())
+    native->call_count++;
+
+  // Intrinsics cannot re-enter the VM or change sp/hp, so they need neither
+  // a native frame nor the saved registers.
+  if (native->intrinsic && native->status == SP_NATIVE_BOUND) {
+    const cell_t* params = reinterpret_cast<const cell_t*>(cx_->memory() + cx_->sp());
+
+    cell_t result;
+    int err = native->intrinsic(cx_, params, &result);
+    if (err != SP_ERROR_NONE) {
+      cx_->ReportErrorNumber(err);
+      return false;
+    }
+    regs_.pri() = result;
+    return true;
+  }
+
   ivk_->enterNativeCall(native_index);
   if (native->status == SP_NATIVE_BOUND) {
     ke::SaveAndSet<cell_t> saveSp(cx_->addressOfSp(), cx_->sp());
@@ -33,6 +33,7 @@ class Environment;
 class PluginContext;
 class PluginRuntime;
 class MethodInfo;
+struct OpcodeCounters;
 
 class InterpRegs
 {
@@ -154,6 +155,8 @@ class Interpreter final : public PcodeVisitor
   Interpreter(PluginContext* cx, RefPtr<MethodInfo> method);
 
   bool run();
+  template <bool kCountOpcodes>
+  bool interpret(OpcodeCounters* counters);
 
   cell_t return_value() const {
     return return_value_;
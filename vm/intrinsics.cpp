@@ -0,0 +1,207 @@
+// vim: set ts=8 sts=2 sw=2 tw=99 et:
+//
+// This file is part of SourcePawn.
+// 
+// SourcePawn is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// SourcePawn is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with SourcePawn.  If not, see <http://www.gnu.org/licenses/>.
+#include <ctype.h>
+#include <string.h>
+#include <amtl/am-utility.h>
+#include "intrinsics.h"
+#include "plugin-context.h"
+
+namespace sp {
+
+using namespace SourcePawn;
+
+// These are the string natives that dominate most plugins' native call
+// counts. Hosts implement them on top of LocalToString(), which does not
+// check termination; here we read plugin memory directly, bound every scan
+// to the region the string lives in, and lean on the libc primitives
+// (strnlen, memmove, strstr) which are already vectorized. Both tiers call
+// them directly rather than through the native's binding.
+
+static int
+CompareNoCase(const char* a, const char* b)
+{
+  for (;; a++, b++) {
+    int ca = tolower(static_cast<unsigned char>(*a));
+    int cb = tolower(static_cast<unsigned char>(*b));
+    if (ca != cb || !ca)
+      return ca - cb;
+  }
+}
+
+// Returns the largest length <= |count| that does not end inside a UTF-8
+// sequence, given that |str| has at least |count| + 1 bytes. SourceMod's
+// string natives never leave half a character behind when they truncate.
+static size_t
+Utf8Truncate(const char* str, size_t count)
+{
+  while (count > 0 && (static_cast<unsigned char>(str[count]) & 0xc0) == 0x80)
+    count--;
+  return count;
+}
+
+static const char*
+FindNoCase(const char* str, const char* substr)
+{
+  size_t sublen = strlen(substr);
+  for (; *str; str++) {
+    size_t i = 0;
+    while (i < sublen &&
+           tolower(static_cast<unsigned char>(str[i])) ==
+           tolower(static_cast<unsigned char>(substr[i])))
+    {
+      i++;
+    }
+    if (i == sublen)
+      return str;
+  }
+  return sublen ? nullptr : str;
+}
+
+// int strlen(const char[] str)
+static int
+Intrinsic_strlen(PluginContext* cx, const cell_t* params, cell_t* result)
+{
+  if (params[0] < 1)
+    return SP_ERROR_PARAM;
+
+  size_t length;
+  if (!cx->checkString(params[1], &length))
+    return SP_ERROR_INVALID_ADDRESS;
+  *result = cell_t(length);
+  return SP_ERROR_NONE;
+}
+
+// int strcmp(const char[] str1, const char[] str2, bool caseSensitive=true)
+static int
+Intrinsic_strcmp(PluginContext* cx, const cell_t* params, cell_t* result)
+{
+  if (params[0] < 3)
+    return SP_ERROR_PARAM;
+
+  size_t len1, len2;
+  const char* str1 = cx->checkString(params[1], &len1);
+  const char* str2 = cx->checkString(params[2], &len2);
+  if (!str1 || !str2)
+    return SP_ERROR_INVALID_ADDRESS;
+
+  *result = params[3] ? strcmp(str1, str2) : CompareNoCase(str1, str2);
+  return SP_ERROR_NONE;
+}
+
+// int strcopy(char[] dest, int destLen, const char[] source)
+static int
+Intrinsic_strcopy(PluginContext* cx, const cell_t* params, cell_t* result)
+{
+  if (params[0] < 3)
+    return SP_ERROR_PARAM;
+
+  *result = 0;
+  cell_t maxlength = params[2];
+  if (maxlength <= 0)
+    return SP_ERROR_NONE;
+
+  char* dest = reinterpret_cast<char*>(cx->checkAddrRange(params[1], maxlength));
+  size_t srclen;
+  const char* src = cx->checkString(params[3], &srclen);
+  if (!dest || !src)
+    return SP_ERROR_INVALID_ADDRESS;
+
+  size_t count = ke::Min(srclen, size_t(maxlength) - 1);
+  if (count < srclen)
+    count = Utf8Truncate(src, count);
+  memmove(dest, src, count);
+  dest[count] = '\0';
+  *result = cell_t(count);
+  return SP_ERROR_NONE;
+}
+
+// int StrCat(char[] buffer, int maxlength, const char[] source)
+static int
+Intrinsic_StrCat(PluginContext* cx, const cell_t* params, cell_t* result)
+{
+  if (params[0] < 3)
+    return SP_ERROR_PARAM;
+
+  *result = 0;
+  cell_t maxlength = params[2];
+  if (maxlength <= 0)
+    return SP_ERROR_NONE;
+
+  char* dest = reinterpret_cast<char*>(cx->checkAddrRange(params[1], maxlength));
+  size_t srclen;
+  const char* src = cx->checkString(params[3], &srclen);
+  if (!dest || !src)
+    return SP_ERROR_INVALID_ADDRESS;
+
+  size_t length = strnlen(dest, maxlength);
+  if (length == size_t(maxlength))
+    return SP_ERROR_NONE;
+
+  size_t count = ke::Min(srclen, size_t(maxlength) - length - 1);
+  if (count < srclen)
+    count = Utf8Truncate(src, count);
+  memmove(dest + length, src, count);
+  dest[length + count] = '\0';
+  *result = cell_t(count);
+  return SP_ERROR_NONE;
+}
+
+// int StrContains(const char[] str, const char[] substr, bool caseSensitive=true)
+static int
+Intrinsic_StrContains(PluginContext* cx, const cell_t* params, cell_t* result)
+{
+  if (params[0] < 3)
+    return SP_ERROR_PARAM;
+
+  size_t len, sublen;
+  const char* str = cx->checkString(params[1], &len);
+  const char* substr = cx->checkString(params[2], &sublen);
+  if (!str || !substr)
+    return SP_ERROR_INVALID_ADDRESS;
+
+  const char* found = params[3]
+                      ? strstr(str, substr)
+                      : FindNoCase(str, substr);
+  *result = found ? cell_t(found - str) : -1;
+  return SP_ERROR_NONE;
+}
+
+struct IntrinsicEntry {
+  const char* name;
+  IntrinsicFn fn;
+};
+
+static const IntrinsicEntry sIntrinsics[] = {
+  {"strlen",      Intrinsic_strlen},
+  {"strcmp",      Intrinsic_strcmp},
+  {"strcopy",     Intrinsic_strcopy},
+  {"StrCat",      Intrinsic_StrCat},
+  {"StrContains", Intrinsic_StrContains},
+  {nullptr,       nullptr},
+};
+
+IntrinsicFn
+FindIntrinsic(const char* name)
+{
+  for (const IntrinsicEntry* iter = sIntrinsics; iter->name; iter++) {
+    if (strcmp(iter->name, name) == 0)
+      return iter->fn;
+  }
+  return nullptr;
+}
+
+} // namespace sp
@@ -0,0 +1,39 @@
+// vim: set ts=8 sts=2 sw=2 tw=99 et:
+//
+// This file is part of SourcePawn.
+// 
+// SourcePawn is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// SourcePawn is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with SourcePawn.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef _include_sourcepawn_vm_intrinsics_h_
+#define _include_sourcepawn_vm_intrinsics_h_
+
+#include <sp_vm_types.h>
+
+namespace sp {
+
+class PluginContext;
+
+// An intrinsic is called directly from the interpreter and from JIT code,
+// without the exit frame a native gets. It must not re-enter the VM or
+// report errors itself; it returns an error code, or SP_ERROR_NONE and sets
+// |result|.
+typedef int (*IntrinsicFn)(PluginContext* cx, const cell_t* params, cell_t* result);
+
+// Returns the VM's implementation of a native with the given name, or null if
+// the VM has no intrinsic for it. Hosts opt in with SP_NTVFLAG_INTRINSIC,
+// which asserts that their own binding behaves identically.
+IntrinsicFn FindIntrinsic(const char* name);
+
+} // namespace sp
+
+#endif // _include_sourcepawn_vm_intrinsics_h_
@@ -61,6 +61,10 @@ CompilerBase::Compile(PluginContext* cx, RefPtr<MethodInfo> method, int *err)
 {
   Compiler cc(cx->runtime(), method->pcode_offset());
 
+  // Size the assembler buffer for the whole method up front, rather than
+  // doubling it repeatedly while emitting large functions.
+  cc.masm.reserve(method->pcode_length() * kNativeBytesPerPcodeByte);
+
   CompiledFunction *fun = cc.emit();
   if (!fun) {
     *err = cc.error();
@@ -68,9 +72,46 @@ CompilerBase::Compile(PluginContext* cx, RefPtr<MethodInfo> method, int *err)
   }
 
   method->setCompiledFunction(fun);
+  PatchPendingCallSites(method);
+  cc.linkThunkedCalls(fun);
   return fun;
 }
 
+// Point call sites that were emitted before |method| was compiled straight at
+// its code, so they don't each have to trip through CompileFromThunk once.
+void
+CompilerBase::PatchPendingCallSites(MethodInfo* method)
+{
+  CompiledFunction* fn = method->jit();
+  assert(fn);
+
+  ke::Vector<uint8_t*>& sites = method->pending_call_sites();
+  for (size_t i = 0; i < sites.length(); i++)
+    PatchCallThunk(sites[i], fn->GetEntryAddress());
+  sites.clear();
+}
+
+// Calls in the function we just compiled whose targets have no code yet go
+// through thunks. Patch the ones that can be resolved now, which includes
+// recursive calls, and leave the rest for when their callee is compiled.
+void
+CompilerBase::linkThunkedCalls(CompiledFunction* fun)
+{
+  uint8_t* base = reinterpret_cast<uint8_t*>(fun->GetEntryAddress());
+  for (size_t i = 0; i < thunked_calls_.length(); i++) {
+    const ThunkedCall& call = thunked_calls_[i];
+    RefPtr<MethodInfo> target = rt_->AcquireMethod(call.target);
+    if (!target)
+      continue;
+
+    uint8_t* pc = base + call.pc;
+    if (CompiledFunction* callee = target->jit())
+      PatchCallThunk(pc, callee->GetEntryAddress());
+    else
+      target->addPendingCallSite(pc);
+  }
+}
+
 CompiledFunction*
 CompilerBase::emit()
 {
@@ -82,7 +123,7 @@ CompilerBase::emit()
       rt_->Name(),
       rt_->image()->LookupFunction(pcode_start_));
 
-  SpewOpcode(rt_, code_start_, reader.cip());
+  SpewOpcode(stdout, rt_, code_start_, reader.cip());
 #endif
 
   const cell_t *codeseg = reinterpret_cast<const cell_t *>(rt_->code().bytes);
@@ -97,7 +138,7 @@ CompilerBase::emit()
       break;
 
 #if defined JIT_SPEW
-    SpewOpcode(rt_, code_start_, reader.cip());
+    SpewOpcode(stdout, rt_, code_start_, reader.cip());
 #endif
 
     // We assume every instruction is a jump target, so before emitting
@@ -107,10 +148,23 @@ CompilerBase::emit()
     // Save the start of the opcode for emitCipMap().
     op_cip_ = reader.cip();
 
+    if (env_->JitDumpEnabled()) {
+      CipMapEntry entry;
+      entry.cipoffs = uintptr_t(op_cip_) - uintptr_t(code_start_);
+      entry.pcoffs = masm.pc();
+      op_map_.append(entry);
+    }
+
+    // Flags are never live across opcodes, so the counter can go first.
+    if (env_->OpcodeCountersEnabled())
+      emitIncrementCounter(&rt_->opcode_counters()->ops[reader.peekOpcode()]);
+
     if (!reader.visitNext() || error_)
       return nullptr;
   }
 
+  uint32_t ool_start = masm.pc();
+
   for (size_t i = 0; i < ool_paths_.length(); i++) {
     OutOfLinePath* path = ool_paths_[i];
     __ bind(path->label());
@@ -151,6 +205,9 @@ CompilerBase::emit()
     return nullptr;
   }
 
+  if (env_->JitDumpEnabled())
+    dumpMethod(code.address(), masm.length(), ool_start);
+
   AutoPtr<FixedArray<LoopEdge>> edges(
     new FixedArray<LoopEdge>(backward_jumps_.length()));
   for (size_t i = 0; i < backward_jumps_.length(); i++) {
@@ -200,6 +257,67 @@ CompilerBase::emitErrorPath(ErrorPath* path)
   emitCipMapping(path->cip);
 }
 
+static void
+DumpCodeBytes(FILE* fp, const uint8_t* code, uint32_t start, uint32_t end)
+{
+  for (uint32_t pc = start; pc < end; pc += 16) {
+    fprintf(fp, "      %04x:", pc);
+    for (uint32_t i = pc; i < end && i < pc + 16; i++)
+      fprintf(fp, " %02x", code[i]);
+    fprintf(fp, "\n");
+  }
+}
+
+void
+CompilerBase::dumpMethod(const uint8_t* code, size_t length, uint32_t ool_start)
+{
+  FILE* fp = stdout;
+
+  const char* name = image_->LookupFunction(pcode_start_);
+  fprintf(fp, "; %s::%s at pcode %u, %u bytes of machine code\n",
+          rt_->Name(), name ? name : "<unknown>", pcode_start_, unsigned(length));
+
+  uint32_t op_counts[OPCODES_TOTAL] = {};
+  uint32_t op_bytes[OPCODES_TOTAL] = {};
+
+  uint32_t last_line = 0;
+  for (size_t i = 0; i < op_map_.length(); i++) {
+    const CipMapEntry& entry = op_map_[i];
+    uint32_t end = (i + 1 < op_map_.length()) ? op_map_[i + 1].pcoffs : ool_start;
+
+    uint32_t line;
+    uint32_t code_offset = pcode_start_ + entry.cipoffs;
+    if (image_->LookupLine(code_offset, &line) && line != last_line) {
+      const char* file = image_->LookupFile(code_offset);
+      fprintf(fp, "; %s:%u\n", file ? file : "<unknown>", line);
+      last_line = line;
+    }
+
+    const cell_t* cip = code_start_ + entry.cipoffs / sizeof(cell_t);
+    SpewOpcode(fp, rt_, code_start_, cip);
+    DumpCodeBytes(fp, code, entry.pcoffs, end);
+
+    // The method was verified, so this is a valid opcode.
+    OPCODE op = (OPCODE)*cip;
+    op_counts[op]++;
+    op_bytes[op] += end - entry.pcoffs;
+  }
+
+  if (ool_start < length) {
+    fprintf(fp, "  out-of-line paths:\n");
+    DumpCodeBytes(fp, code, ool_start, uint32_t(length));
+  }
+
+  fprintf(fp, "; code size by opcode:\n");
+  for (size_t op = 0; op < OPCODES_TOTAL; op++) {
+    if (!op_counts[op])
+      continue;
+    fprintf(fp, ";   %-16s %6u ops %8u bytes\n",
+            OpcodeNames[op], op_counts[op], op_bytes[op]);
+  }
+  fprintf(fp, "\n");
+}
+
 void
 CompilerBase::emitThrowPathIfNeeded(int err)
 {
@@ -35,6 +35,22 @@ class PluginRuntime;
 class PluginContext;
 class LegacyImage;
 
+// A call instruction that goes through a compile thunk, because its target
+// was not compiled yet.
+struct ThunkedCall {
+  // The pc at the call instruction (i.e. after it).
+  uint32_t pc;
+  // The pcode offset of the callee.
+  cell_t target;
+
+  ThunkedCall()
+  {}
+  ThunkedCall(uint32_t pc, cell_t target)
+   : pc(pc),
+     target(target)
+  {}
+};
+
 struct BackwardJump {
   // The pc at the jump instruction (i.e. after it).
   uint32_t pc;
@@ -55,6 +71,10 @@ class CompilerBase : public PcodeVisitor
 {
   friend class ErrorPath;
 
+  // Rough ratio of emitted machine code to pcode, used to pre-size the
+  // assembler buffer.
+  static const size_t kNativeBytesPerPcodeByte = 2;
+
  public:
   CompilerBase(PluginRuntime *rt, cell_t pcode_offs);
   virtual ~CompilerBase();
@@ -72,6 +92,7 @@ class CompilerBase : public PcodeVisitor
   virtual void emitThrowPath(int err) = 0;
   virtual void emitErrorHandlers() = 0;
   virtual void emitOutOfBoundsErrorPath(OutOfBoundsErrorPath* path) = 0;
+  virtual void emitIncrementCounter(uint64_t* counter) = 0;
 
   // Helpers.
   static int CompileFromThunk(PluginContext* cx, cell_t pcode_offs, void **addrp, uint8_t* pc);
@@ -80,6 +101,10 @@ class CompilerBase : public PcodeVisitor
   static void InvokeReportTimeout();
   static void PatchCallThunk(uint8_t* pc, void* target);
 
+  void linkThunkedCalls(CompiledFunction* fun);
+  void dumpMethod(const uint8_t* code, size_t length, uint32_t ool_start);
+  static void PatchPendingCallSites(MethodInfo* method);
+
  protected:
   cell_t readCell();
 
@@ -123,7 +148,11 @@ class CompilerBase : public PcodeVisitor
   Label return_reported_error_;
 
   ke::Vector<BackwardJump> backward_jumps_;
+  ke::Vector<ThunkedCall> thunked_calls_;
   ke::Vector<CipMapEntry> cip_map_;
+
+  // Start of each opcode's code, only recorded when dumping.
+  ke::Vector<CipMapEntry> op_map_;
 };
 
 } // namespace sp
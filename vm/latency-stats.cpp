@@ -0,0 +1,56 @@
+// vim: set sts=2 ts=8 sw=2 tw=99 et:
+// 
+// Copyright (C) 2006-2015 AlliedModders LLC
+// 
+// This file is part of SourcePawn. SourcePawn is free software: you can
+// redistribute it and/or modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+//
+// You should have received a copy of the GNU General Public License along with
+// SourcePawn. If not, see http://www.gnu.org/licenses/.
+//
+#include "latency-stats.h"
+#if defined(_WIN32)
+# include <Windows.h>
+#else
+# include <time.h>
+#endif
+
+namespace sp {
+
+uint64_t
+NanoTime()
+{
+#if defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  if (!frequency.QuadPart)
+    QueryPerformanceFrequency(&frequency);
+
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  uint64_t seconds = now.QuadPart / frequency.QuadPart;
+  uint64_t remainder = now.QuadPart % frequency.QuadPart;
+  return seconds * 1000000000 + remainder * 1000000000 / frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void
+RecordLatency(sp_latency_stats_t* stats, uint64_t ns)
+{
+  unsigned bucket = 0;
+  while (bucket < SP_LATENCY_BUCKETS - 1 && (ns >> (bucket + 1)))
+    bucket++;
+
+  stats->calls++;
+  stats->total_ns += ns;
+  if (ns > stats->max_ns)
+    stats->max_ns = ns;
+  stats->buckets[bucket]++;
+}
+
+} // namespace sp
@@ -0,0 +1,28 @@
+// vim: set sts=2 ts=8 sw=2 tw=99 et:
+// 
+// Copyright (C) 2006-2015 AlliedModders LLC
+// 
+// This file is part of SourcePawn. SourcePawn is free software: you can
+// redistribute it and/or modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation, either version 3 of
+// the License, or (at your option) any later version.
+//
+// You should have received a copy of the GNU General Public License along with
+// SourcePawn. If not, see http://www.gnu.org/licenses/.
+//
+#ifndef _include_sourcepawn_vm_latency_stats_h_
+#define _include_sourcepawn_vm_latency_stats_h_
+
+#include <sp_vm_types.h>
+
+namespace sp {
+
+// Returns a monotonic timestamp, in nanoseconds.
+uint64_t NanoTime();
+
+// Adds one call of |ns| nanoseconds to a histogram.
+void RecordLatency(sp_latency_stats_t* stats, uint64_t ns);
+
+} // namespace sp
+
+#endif // _include_sourcepawn_vm_latency_stats_h_
@@ -14,6 +14,7 @@
 #define _include_sourcepawn_vm_legacy_image_h_
 
 #include <string.h>
+#include <sp_vm_types.h>
 
 namespace sp {
 
@@ -58,6 +59,8 @@ class LegacyImage
   virtual const char *LookupFile(uint32_t code_offset) = 0;
   virtual const char *LookupFunction(uint32_t code_offset) = 0;
   virtual bool LookupLine(uint32_t code_offset, uint32_t *line) = 0;
+  virtual bool LookupFormat(uint32_t address, const sp_format_spec_t **specs,
+                            uint32_t *count) const = 0;
 };
 
 class EmptyImage : public LegacyImage
@@ -126,6 +129,10 @@ class EmptyImage : public LegacyImage
   bool LookupLine(uint32_t code_offset, uint32_t *line) override {
     return false;
   }
+  bool LookupFormat(uint32_t address, const sp_format_spec_t **specs,
+                    uint32_t *count) const override {
+    return false;
+  }
 
  private:
   size_t heap_size_;
@@ -20,8 +20,11 @@ namespace sp {
 MethodInfo::MethodInfo(PluginRuntime* rt, uint32_t codeOffset)
  : rt_(rt),
    pcode_offset_(codeOffset),
+   pcode_length_(0),
    checked_(false),
-   validation_error_(SP_ERROR_NONE)
+   validation_error_(SP_ERROR_NONE),
+   invocation_count_(0),
+   host_invocations_(0)
 {
 }
 
@@ -46,6 +49,8 @@ MethodInfo::InternalValidate()
   MethodVerifier verifier(rt_, pcode_offset_);
   if (!verifier.verify())
     validation_error_ = verifier.error();
+  else
+    pcode_length_ = verifier.codeLength();
 
   checked_ = true;
 }
@@ -15,6 +15,7 @@
 
 #include <sp_vm_types.h>
 #include <amtl/am-refcounting.h>
+#include <amtl/am-vector.h>
 
 namespace sp {
 
@@ -37,21 +38,56 @@ class MethodInfo final : public ke::Refcounted<MethodInfo>
     return pcode_offset_;
   }
 
+  // Only valid once the method has been validated.
+  uint32_t pcode_length() const {
+    return pcode_length_;
+  }
+
   void setCompiledFunction(CompiledFunction* fun);
   CompiledFunction* jit() const {
     return jit_;
   }
 
+  // Only maintained if method counters are enabled in the environment.
+  uint32_t invocation_count() const {
+    return invocation_count_;
+  }
+  void countInvocation() {
+    invocation_count_++;
+  }
+  uint32_t* addressOfInvocationCount() {
+    return &invocation_count_;
+  }
+
+  // Call sites in compiled code that reach this method through a compile
+  // thunk. They are patched to call it directly once it is compiled.
+  void addPendingCallSite(uint8_t* pc) {
+    pending_call_sites_.append(pc);
+  }
+  ke::Vector<uint8_t*>& pending_call_sites() {
+    return pending_call_sites_;
+  }
+
+  // Counts entries from the host while the method is not yet compiled, and
+  // returns the new count.
+  uint32_t countHostInvocation() {
+    return ++host_invocations_;
+  }
+
  private:
   void InternalValidate();
 
  private:
   PluginRuntime* rt_;
   uint32_t pcode_offset_;
+  uint32_t pcode_length_;
   ke::AutoPtr<CompiledFunction> jit_;
+  ke::Vector<uint8_t*> pending_call_sites_;
 
   bool checked_;
   int validation_error_;
+  uint32_t invocation_count_;
+  uint32_t host_invocations_;
 };
 
 } // namespace sp
@@ -35,6 +35,11 @@ class MethodVerifier final
     return error_;
   }
 
+  // Size of the method's pcode in bytes, valid after a successful verify().
+  uint32_t codeLength() const {
+    return uint32_t(uintptr_t(cip_) - uintptr_t(method_));
+  }
+
  private:
   bool more() const {
     return cip_ < stop_at_;
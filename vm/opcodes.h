@@ -32,14 +32,15 @@
 #ifndef _INCLUDE_SOURCEPAWN_JIT_X86_OPCODES_H_
 #define _INCLUDE_SOURCEPAWN_JIT_X86_OPCODES_H_
 
+#include <stdio.h>
 #include <smx/smx-v1-opcodes.h>
 #include <sp_vm_types.h>
 #include "plugin-runtime.h"
 
+extern const char *OpcodeNames[];
+
 namespace SourcePawn {
-#ifdef JIT_SPEW
-	void SpewOpcode(sp::PluginRuntime *runtime, const cell_t *start, const cell_t *cip);
-#endif
+	void SpewOpcode(FILE *fp, sp::PluginRuntime *runtime, const cell_t *start, const cell_t *cip);
 }
 
 #endif //_INCLUDE_SOURCEPAWN_JIT_X86_OPCODES_H_
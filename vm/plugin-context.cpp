@@ -19,6 +19,7 @@
 #include "watchdog_timer.h"
 #include "environment.h"
 #include "method-info.h"
+#include "latency-stats.h"
 
 using namespace sp;
 using namespace SourcePawn;
@@ -59,16 +60,19 @@ PluginContext::PluginContext(PluginRuntime *pRuntime)
 PluginContext::~PluginContext()
 {
   free(tracker_.pBase);
-  delete[] memory_;
+  free(memory_);
 }
 
 bool
 PluginContext::Initialize()
 {
-  memory_ = new uint8_t[mem_size_];
+  // Most plugins never come close to using their whole stack/heap region.
+  // Get zeroed memory from calloc rather than clearing it by hand, so that
+  // allocators which map large blocks on demand never commit the pages that
+  // the plugin does not touch.
+  memory_ = (uint8_t *)calloc(mem_size_, 1);
   if (!memory_)
     return false;
-  memset(memory_ + data_size_, 0, mem_size_ - data_size_);
   memcpy(memory_, m_pRuntime->data().bytes, data_size_);
 
   /* Initialize the null references */
@@ -436,18 +440,13 @@ PluginContext::Invoke(funcid_t fnid, const cell_t *params, unsigned int num_para
   /* We got this far.  It's time to start profiling. */
   EnterProfileScope scriptScope("SourcePawn", cfun->DebugName());
 
-  /* See if we have to compile the callee. */
-  RefPtr<MethodInfo> method = cfun->AcquireMethod();
-  if (!method) {
-    ReportErrorNumber(SP_ERROR_INVALID_ADDRESS);
-    return false;
-  }
-
-  int err = method->Validate();
+  /* See if we have to validate the callee. This is only done once. */
+  int err = cfun->EnsureReady();
   if (err != SP_ERROR_NONE) {
     ReportErrorNumber(err);
     return false;
   }
+  const RefPtr<MethodInfo>& method = cfun->method();
 
   /* Save our previous state. */
   cell_t save_sp = sp_;
@@ -462,7 +461,11 @@ PluginContext::Invoke(funcid_t fnid, const cell_t *params, unsigned int num_para
     sp[i + 1] = params[i];
 
   // Enter the execution engine.
+  sp_latency_stats_t *latency = m_pRuntime->LatencyStatsFor(public_id);
+  uint64_t start = latency ? NanoTime() : 0;
   bool ok = env_->Invoke(this, method, result);
+  if (latency)
+    RecordLatency(latency, NanoTime() - start);
 
   if (ok) {
     // Verify that our state is still sane.
@@ -501,6 +504,16 @@ PluginContext::GetLocalParams()
   return (cell_t *)(memory_ + frm_ + (2 * sizeof(cell_t)));
 }
 
+bool
+PluginContext::GetFormatSpecs(cell_t local_addr, const sp_format_spec_t **specs,
+                              uint32_t *count)
+{
+  // Pre-parsed strings are literals, which only live in the data section.
+  if (local_addr < 0 || ucell_t(local_addr) >= data_size_)
+    return false;
+  return m_pRuntime->image()->LookupFormat(local_addr, specs, count);
+}
+
 int
 PluginContext::popTrackerAndSetHeap()
 {
@@ -842,16 +855,38 @@ PluginContext::acquireAddrRange(cell_t address, uint32_t bounds)
 cell_t*
 PluginContext::throwIfBadAddress(cell_t addr)
 {
-  if (addr < 0 ||
-      (addr >= hp_ && addr < sp_) ||
-      addr >= stp_)
-  {
+  if (!isValidAddress(addr)) {
     ReportErrorNumber(SP_ERROR_INVALID_ADDRESS);
     return nullptr;
   }
   return reinterpret_cast<cell_t*>(memory_ + addr);
 }
 
+cell_t*
+PluginContext::checkAddrRange(cell_t address, uint32_t bounds)
+{
+  if (!isValidAddress(address))
+    return nullptr;
+  if (bounds && !isValidAddress(address + bounds - 1))
+    return nullptr;
+  return reinterpret_cast<cell_t*>(memory_ + address);
+}
+
+char*
+PluginContext::checkString(cell_t address, size_t* length)
+{
+  if (!isValidAddress(address))
+    return nullptr;
+
+  // Strings may not run off the end of the region they start in.
+  size_t limit = (address < hp_) ? hp_ - address : stp_ - address;
+  char* str = reinterpret_cast<char*>(memory_ + address);
+  *length = strnlen(str, limit);
+  if (*length == limit)
+    return nullptr;
+  return str;
+}
+
 bool
 PluginContext::addStack(cell_t amount)
 {
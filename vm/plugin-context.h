@@ -69,6 +69,8 @@ class PluginContext : public BasePluginContext
   int LocalToStringNULL(cell_t local_addr, char **addr) override;
   IPluginRuntime *GetRuntime() override;
   cell_t *GetLocalParams() override;
+  bool GetFormatSpecs(cell_t local_addr, const sp_format_spec_t **specs,
+                      uint32_t *count) override;
 
   bool Invoke(funcid_t fnid, const cell_t *params, unsigned int num_params, cell_t *result);
 
@@ -139,10 +141,19 @@ class PluginContext : public BasePluginContext
   bool setCellValue(cell_t address, cell_t value);
   bool heapAlloc(cell_t amount, cell_t* out);
   cell_t* acquireAddrRange(cell_t address, uint32_t bounds);
-
   cell_t* throwIfBadAddress(cell_t addr);
 
+  // These return null instead of reporting an error, for VM intrinsics, which
+  // run without an exit frame. A string must be terminated within the region
+  // it starts in.
+  cell_t* checkAddrRange(cell_t address, uint32_t bounds);
+  char* checkString(cell_t address, size_t* length);
+
  private:
+  bool isValidAddress(cell_t addr) const {
+    return addr >= 0 && (addr < hp_ || addr >= sp_) && addr < stp_;
+  }
+
   PluginRuntime *m_pRuntime;
   uint8_t *memory_;
   uint32_t data_size_;
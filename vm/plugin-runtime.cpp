@@ -15,10 +15,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
 #include <smx/smx-v1-opcodes.h>
 #include "compiled-function.h"
 #include "environment.h"
+#include "intrinsics.h"
 #include "method-info.h"
+#include "opcodes.h"
 #include "plugin-context.h"
 
 #include "md5/md5.h"
@@ -29,6 +32,7 @@ using namespace SourcePawn;
 PluginRuntime::PluginRuntime(LegacyImage *image)
  : image_(image),
    paused_(false),
+   latency_tracking_(false),
    computed_code_hash_(false),
    computed_data_hash_(false)
 {
@@ -53,6 +57,11 @@ PluginRuntime::~PluginRuntime()
 
   for (uint32_t i = 0; i < image_->NumPublics(); i++)
     delete entrypoints_[i];
+
+  if (natives_) {
+    for (uint32_t i = 0; i < image_->NumNatives(); i++)
+      ReleaseVectorStub(&natives_[i]);
+  }
 }
 
 bool
@@ -228,6 +237,80 @@ PluginRuntime::AllMethods() const
   return methods_;
 }
 
+bool
+PluginRuntime::WriteMethodProfile(FILE* fp)
+{
+  ke::AutoLock lock(Environment::get()->lock());
+
+  for (size_t i = 0; i < methods_.length(); i++) {
+    const RefPtr<MethodInfo>& method = methods_[i];
+    if (!method->invocation_count())
+      continue;
+
+    const char* name = image_->LookupFunction(method->pcode_offset());
+    if (fprintf(fp, "%u %u %s\n",
+                method->pcode_offset(),
+                method->invocation_count(),
+                name ? name : "?") < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+OpcodeCounters*
+PluginRuntime::opcode_counters()
+{
+  if (!opcode_counters_)
+    opcode_counters_ = new OpcodeCounters();
+  return opcode_counters_;
+}
+
+bool
+PluginRuntime::WriteOpcodeProfile(FILE* fp)
+{
+  if (opcode_counters_) {
+    for (size_t op = 0; op < OPCODES_TOTAL; op++) {
+      if (!opcode_counters_->ops[op])
+        continue;
+      if (fprintf(fp, "op %s %llu\n",
+                  OpcodeNames[op],
+                  (unsigned long long)opcode_counters_->ops[op]) < 0)
+      {
+        return false;
+      }
+    }
+    for (size_t prev = 0; prev < OPCODES_TOTAL; prev++) {
+      for (size_t op = 0; op < OPCODES_TOTAL; op++) {
+        uint64_t count = opcode_counters_->pairs[prev][op];
+        if (!count)
+          continue;
+        if (fprintf(fp, "pair %s %s %llu\n",
+                    OpcodeNames[prev],
+                    OpcodeNames[op],
+                    (unsigned long long)count) < 0)
+        {
+          return false;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < image_->NumNatives(); i++) {
+    const NativeEntry& native = natives_[i];
+    if (!native.call_count)
+      continue;
+    if (fprintf(fp, "native %s %llu\n",
+                native.name,
+                (unsigned long long)native.call_count) < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 int
 PluginRuntime::FindNativeByName(const char *name, uint32_t *index)
 {
@@ -249,6 +332,14 @@ PluginRuntime::GetNativeByIndex(uint32_t index, sp_native_t **native)
 
 int
 PluginRuntime::UpdateNativeBinding(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_t flags, void *data)
+{
+  // Only UpdateVectorNativeBinding may mark a binding as a vector stub, since
+  // the stub is destroyed when the native is rebound.
+  return BindNative(index, pfn, flags & ~SP_NTVFLAG_VECTOR, data);
+}
+
+int
+PluginRuntime::BindNative(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_t flags, void *data)
 {
   if (index >= image_->NumNatives())
     return SP_ERROR_INDEX;
@@ -264,6 +355,13 @@ PluginRuntime::UpdateNativeBinding(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_
     return SP_ERROR_PARAM;
   }
 
+  ReleaseVectorStub(native);
+
+  // The host has promised its binding behaves like ours, so run ours.
+  native->intrinsic = (pfn && (flags & SP_NTVFLAG_INTRINSIC))
+                      ? FindIntrinsic(image_->GetNative(index))
+                      : nullptr;
+
   native->legacy_fn = pfn;
   native->status = pfn
                    ? SP_NATIVE_BOUND
@@ -273,6 +371,81 @@ PluginRuntime::UpdateNativeBinding(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_
   return SP_ERROR_NONE;
 }
 
+int
+PluginRuntime::UpdateVectorNativeBinding(uint32_t index, SPVM_VECTOR_NATIVE_FUNC pfn,
+                                         uint32_t arity, uint32_t flags, void *data)
+{
+  if (index >= image_->NumNatives())
+    return SP_ERROR_INDEX;
+  if (!pfn || !arity)
+    return SP_ERROR_PARAM;
+
+  NativeEntry* native = &natives_[index];
+
+  SPVM_NATIVE_FUNC stub =
+    Environment::get()->APIv2()->CreateFakeNative(InvokeVectorNative, native);
+  if (!stub)
+    return SP_ERROR_OUT_OF_MEMORY;
+
+  // A vector native has no intrinsic counterpart.
+  flags &= ~SP_NTVFLAG_INTRINSIC;
+
+  int err = BindNative(index, stub, flags | SP_NTVFLAG_VECTOR, data);
+  if (err != SP_ERROR_NONE) {
+    Environment::get()->APIv2()->DestroyFakeNative(stub);
+    return err;
+  }
+
+  native->vector_fn = pfn;
+  native->vector_arity = arity;
+  return SP_ERROR_NONE;
+}
+
+void
+PluginRuntime::ReleaseVectorStub(NativeEntry* native)
+{
+  if (!(native->flags & SP_NTVFLAG_VECTOR) || !native->legacy_fn)
+    return;
+
+  Environment::get()->APIv2()->DestroyFakeNative(native->legacy_fn);
+  native->legacy_fn = nullptr;
+  native->vector_fn = nullptr;
+  native->vector_arity = 0;
+}
+
+cell_t
+PluginRuntime::InvokeVectorNative(IPluginContext* pcx, const cell_t* params, void* data)
+{
+  NativeEntry* native = reinterpret_cast<NativeEntry*>(data);
+  PluginContext* cx = FromAPI(pcx->GetRuntime())->GetBaseContext();
+
+  if (params[0] < 3)
+    return pcx->ThrowNativeErrorEx(SP_ERROR_PARAM, "expected (args[], results[], count)");
+
+  cell_t count = params[3];
+  if (count < 0)
+    return pcx->ThrowNativeErrorEx(SP_ERROR_PARAM, "invalid batch size %d", count);
+  if (count == 0)
+    return 0;
+
+  // Keep the byte sizes below in range before validating the arrays.
+  uint32_t arity = native->vector_arity;
+  if (uint32_t(count) > uint32_t(INT_MAX) / sizeof(cell_t) / arity)
+    return pcx->ThrowNativeErrorEx(SP_ERROR_ARRAY_TOO_BIG, nullptr);
+
+  cell_t* args = cx->acquireAddrRange(params[1], count * arity * sizeof(cell_t));
+  if (!args)
+    return 0;
+  cell_t* results = cx->acquireAddrRange(params[2], count * sizeof(cell_t));
+  if (!results)
+    return 0;
+
+  int err = native->vector_fn(pcx, args, arity, count, results, native->user);
+  if (err != SP_ERROR_NONE)
+    return pcx->ThrowNativeErrorEx(err, nullptr);
+  return 0;
+}
+
 const sp_native_t *
 PluginRuntime::GetNative(uint32_t index)
 {
@@ -427,6 +600,37 @@ PluginRuntime::GetPublicFunction(size_t index)
   return pFunc;
 }
 
+void
+PluginRuntime::SetLatencyTracking(bool enabled)
+{
+  if (enabled && !latency_stats_) {
+    size_t count = image_->NumPublics();
+    latency_stats_ = MakeUnique<sp_latency_stats_t[]>(count);
+    memset(latency_stats_.get(), 0, sizeof(sp_latency_stats_t) * count);
+  }
+  latency_tracking_ = enabled;
+}
+
+int
+PluginRuntime::GetPublicLatency(uint32_t index, sp_latency_stats_t *stats)
+{
+  if (index >= image_->NumPublics())
+    return SP_ERROR_INDEX;
+
+  if (latency_stats_)
+    *stats = latency_stats_[index];
+  else
+    memset(stats, 0, sizeof(*stats));
+  return SP_ERROR_NONE;
+}
+
+void
+PluginRuntime::ResetLatencyStats()
+{
+  if (latency_stats_)
+    memset(latency_stats_.get(), 0, sizeof(sp_latency_stats_t) * image_->NumPublics());
+}
+
 IPluginFunction *
 PluginRuntime::GetFunctionByName(const char *public_name)
 {
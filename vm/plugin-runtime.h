@@ -19,8 +19,10 @@
 #include <am-inlinelist.h>
 #include <am-hashmap.h>
 #include <amtl/am-refcounting.h>
+#include <smx/smx-v1-opcodes.h>
 #include "scripted-invoker.h"
 #include "legacy-image.h"
+#include "intrinsics.h"
 
 namespace sp {
 
@@ -42,9 +44,34 @@ struct floattbl_t
 struct NativeEntry : public sp_native_t
 {
   NativeEntry()
-   : legacy_fn(nullptr)
+   : legacy_fn(nullptr),
+     vector_fn(nullptr),
+     vector_arity(0),
+     intrinsic(nullptr),
+     call_count(0)
   {}
   SPVM_NATIVE_FUNC legacy_fn;
+
+  // For SP_NTVFLAG_VECTOR natives, |legacy_fn| is a fake native stub that
+  // validates the batch and forwards it here.
+  SPVM_VECTOR_NATIVE_FUNC vector_fn;
+  uint32_t vector_arity;
+
+  // For SP_NTVFLAG_INTRINSIC natives the VM implements, both tiers call this
+  // directly instead of |legacy_fn|, which keeps the host's binding.
+  IntrinsicFn intrinsic;
+
+  // Only maintained if opcode counters are enabled in the environment.
+  uint64_t call_count;
+};
+
+// Execution counts, only maintained if opcode counters are enabled in the
+// environment. Pairs are indexed by [previous][current] opcode within a
+// method, and are only collected by the interpreter.
+struct OpcodeCounters
+{
+  uint64_t ops[OPCODES_TOTAL];
+  uint64_t pairs[OPCODES_TOTAL][OPCODES_TOTAL];
 };
 
 /* Jit wants fast access to this so we expose things as public */
@@ -85,6 +112,8 @@ class PluginRuntime
   unsigned GetNativeReplacement(size_t index);
   ScriptedInvoker *GetPublicFunction(size_t index);
   int UpdateNativeBinding(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_t flags, void *data) override;
+  int UpdateVectorNativeBinding(uint32_t index, SPVM_VECTOR_NATIVE_FUNC pfn,
+                                uint32_t arity, uint32_t flags, void *data) override;
   const sp_native_t *GetNative(uint32_t index) override;
   int LookupLine(ucell_t addr, uint32_t *line) override;
   int LookupFunction(ucell_t addr, const char **name) override;
@@ -92,6 +121,17 @@ class PluginRuntime
   const char *GetFilename() override {
     return full_name_.chars();
   }
+  void SetLatencyTracking(bool enabled) override;
+  int GetPublicLatency(uint32_t index, sp_latency_stats_t *stats) override;
+  void ResetLatencyStats() override;
+
+  // Returns where to record host calls into a public function, or null if
+  // latency tracking is off.
+  sp_latency_stats_t* LatencyStatsFor(size_t public_index) {
+    if (!latency_tracking_)
+      return nullptr;
+    return &latency_stats_[public_index];
+  }
 
   // Mark builtin natives as bound.
   void InstallBuiltinNatives();
@@ -106,6 +146,21 @@ class PluginRuntime
   // Return a list of all methods. The caller must own the environment lock.
   const ke::Vector<RefPtr<MethodInfo>>& AllMethods() const;
 
+  // Write the invocation count of every method that has been entered, one
+  // "<pcode offset> <count> <name>" line per method. Counts are only
+  // collected if method counters are enabled in the environment. spcomp -P
+  // reads this file back, but only uses it to give frequently entered stocks
+  // that take no arguments a larger inlining budget.
+  bool WriteMethodProfile(FILE* fp);
+
+  // Allocated on first use.
+  OpcodeCounters* opcode_counters();
+
+  // Write non-zero opcode, opcode pair and native call counts, one
+  // "op <name> <count>", "pair <name> <name> <count>" or
+  // "native <name> <count>" line each.
+  bool WriteOpcodeProfile(FILE* fp);
+
   NativeEntry* NativeAt(size_t index) {
     return &natives_[index];
   }
@@ -139,6 +194,9 @@ class PluginRuntime
 
  private:
   void SetupFloatNativeRemapping();
+  int BindNative(uint32_t index, SPVM_NATIVE_FUNC pfn, uint32_t flags, void *data);
+  static void ReleaseVectorStub(NativeEntry* native);
+  static cell_t InvokeVectorNative(SourcePawn::IPluginContext* cx, const cell_t* params, void* data);
 
  private:
   ke::AutoPtr<sp::LegacyImage> image_;
@@ -153,6 +211,8 @@ class PluginRuntime
   ke::AutoPtr<sp_pubvar_t[]> pubvars_;
   ke::AutoPtr<ScriptedInvoker*[]> entrypoints_;
   ke::AutoPtr<PluginContext> context_;
+  ke::AutoPtr<sp_latency_stats_t[]> latency_stats_;
+  ke::AutoPtr<OpcodeCounters> opcode_counters_;
 
   struct FunctionMapPolicy {
     static inline uint32_t hash(ucell_t value) {
@@ -170,6 +230,8 @@ class PluginRuntime
   // Pause state.
   bool paused_;
 
+  bool latency_tracking_;
+
   // Checksumming.
   bool computed_code_hash_;
   bool computed_data_hash_;
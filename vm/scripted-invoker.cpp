@@ -31,7 +31,8 @@ ScriptedInvoker::ScriptedInvoker(PluginRuntime *runtime, funcid_t id, uint32_t p
    context_(runtime->GetBaseContext()),
    m_curparam(0),
    m_errorstate(SP_ERROR_NONE),
-   m_FnId(id)
+   m_FnId(id),
+   ready_(false)
 {
   runtime->GetPublicByIndex(pub_id, &public_);
 
@@ -352,10 +353,18 @@ ScriptedInvoker::SetError(int err)
   return err;
 }
 
-RefPtr<MethodInfo>
-ScriptedInvoker::AcquireMethod()
+int
+ScriptedInvoker::PrepareMethod()
 {
   if (!method_)
     method_ = context_->runtime()->AcquireMethod(public_->code_offs);
-  return method_;
+  if (!method_)
+    return SP_ERROR_INVALID_ADDRESS;
+
+  int err = method_->Validate();
+  if (err != SP_ERROR_NONE)
+    return err;
+
+  ready_ = true;
+  return SP_ERROR_NONE;
 }
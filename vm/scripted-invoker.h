@@ -77,12 +77,21 @@ class ScriptedInvoker : public IPluginFunction
     return public_;
   }
 
-  // Helper for pRuntime->AcquireMethod that caches the result.
-  RefPtr<MethodInfo> AcquireMethod();
+  // Acquires and validates the method on first use. Afterwards, this is a
+  // single flag test, and method() can be used without touching refcounts.
+  int EnsureReady() {
+    if (ready_)
+      return SP_ERROR_NONE;
+    return PrepareMethod();
+  }
+  const RefPtr<MethodInfo>& method() const {
+    return method_;
+  }
 
  private:
   int _PushString(const char *string, int sz_flags, int cp_flags, size_t len);
   int SetError(int err);
+  int PrepareMethod();
 
  private:
   Environment *env_;
@@ -95,6 +104,7 @@ class ScriptedInvoker : public IPluginFunction
   ke::AutoPtr<char[]> full_name_;
   sp_public_t *public_;
   RefPtr<MethodInfo> method_;
+  bool ready_;
 };
 
 } // namespace sp
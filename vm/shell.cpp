@@ -16,6 +16,7 @@
 #include <am-cxx.h>
 #include "dll_exports.h"
 #include "environment.h"
+#include "latency-stats.h"
 #include "stack-frames.h"
 
 #ifdef __EMSCRIPTEN__
@@ -130,6 +131,55 @@ static void BindNative(IPluginRuntime *rt, const char *name, SPVM_NATIVE_FUNC fn
   rt->UpdateNativeBinding(index, fn, 0, nullptr);
 }
 
+static int SumTuples(IPluginContext *cx, const cell_t *args, uint32_t arity, uint32_t count,
+                     cell_t *results, void *data)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    results[i] = 0;
+    for (uint32_t j = 0; j < arity; j++)
+      results[i] += args[i * arity + j];
+  }
+  return SP_ERROR_NONE;
+}
+
+static void BindVectorNative(IPluginRuntime *rt, const char *name, SPVM_VECTOR_NATIVE_FUNC fn,
+                             uint32_t arity)
+{
+  int err;
+  uint32_t index;
+  if ((err = rt->FindNativeByName(name, &index)) != SP_ERROR_NONE)
+    return;
+
+  rt->UpdateVectorNativeBinding(index, fn, arity, 0, nullptr);
+}
+
+// The shell has no string natives of its own; these exist only so the VM's
+// intrinsics have something to stand in for.
+static cell_t MissingIntrinsic(IPluginContext *cx, const cell_t *params)
+{
+  cx->ReportError("native has no VM intrinsic");
+  return 0;
+}
+
+static void BindIntrinsic(IPluginRuntime *rt, const char *name)
+{
+  int err;
+  uint32_t index;
+  if ((err = rt->FindNativeByName(name, &index)) != SP_ERROR_NONE)
+    return;
+
+  rt->UpdateNativeBinding(index, MissingIntrinsic, SP_NTVFLAG_INTRINSIC, nullptr);
+}
+
+static cell_t CountFormatSpecs(IPluginContext *cx, const cell_t *params)
+{
+  const sp_format_spec_t *specs;
+  uint32_t count;
+  if (!cx->GetFormatSpecs(params[1], &specs, &count))
+    return -1;
+  return count;
+}
+
 static cell_t PrintFloat(IPluginContext *cx, const cell_t *params)
 {
   return printf("%f\n", sp_ctof(params[1]));
@@ -143,8 +193,8 @@ static cell_t WriteFloat(IPluginContext *cx, const cell_t *params)
 static cell_t DoExecute(IPluginContext *cx, const cell_t *params)
 {
   int32_t ok = 0;
-  for (size_t i = 0; i < size_t(params[2]); i++) {
-    if (IPluginFunction *fn = cx->GetFunctionById(params[1])) {
+  for (size_t i = 0; i < size_t(params[1]); i++) {
+    if (IPluginFunction *fn = cx->GetFunctionById(params[2])) {
       if (fn->Execute(nullptr) != SP_ERROR_NONE)
         continue;
       ok++;
@@ -155,8 +205,8 @@ static cell_t DoExecute(IPluginContext *cx, const cell_t *params)
 
 static cell_t DoInvoke(IPluginContext *cx, const cell_t *params)
 {
-  for (size_t i = 0; i < size_t(params[2]); i++) {
-    if (IPluginFunction *fn = cx->GetFunctionById(params[1])) {
+  for (size_t i = 0; i < size_t(params[1]); i++) {
+    if (IPluginFunction *fn = cx->GetFunctionById(params[2])) {
       if (!fn->Invoke())
         return 0;
     }
@@ -164,6 +214,86 @@ static cell_t DoInvoke(IPluginContext *cx, const cell_t *params)
   return 1;
 }
 
+static cell_t JitEnabled(IPluginContext *cx, const cell_t *params)
+{
+  return sEnv->IsJitEnabled();
+}
+
+static cell_t InJit(IPluginContext *cx, const cell_t *params)
+{
+  InvokeFrame *frame = sEnv->top();
+  return frame && frame->AsJitInvokeFrame();
+}
+
+static cell_t LatencyTracking(IPluginContext *cx, const cell_t *params)
+{
+  cx->GetRuntime()->SetLatencyTracking(!!params[1]);
+  return 0;
+}
+
+// Call times vary from run to run, so only print what must hold for any
+// histogram: the buckets add up to the call count, the percentiles are
+// ordered, and the 100th percentile is the longest call.
+static void PrintLatencyChecks(const sp_latency_stats_t *stats)
+{
+  uint64_t sum = 0;
+  for (size_t i = 0; i < SP_LATENCY_BUCKETS; i++)
+    sum += stats->buckets[i];
+
+  uint64_t p50 = sp_latency_percentile(stats, 0.5);
+  uint64_t p99 = sp_latency_percentile(stats, 0.99);
+  uint64_t p100 = sp_latency_percentile(stats, 1.0);
+  printf("calls %d\n", int(stats->calls));
+  printf("buckets %d\n", sum == stats->calls);
+  printf("ordered %d\n", p50 <= p99 && p99 <= p100 && p100 == stats->max_ns);
+}
+
+static cell_t PrintPublicLatency(IPluginContext *cx, const cell_t *params)
+{
+  char *name;
+  cx->LocalToString(params[1], &name);
+
+  uint32_t index;
+  int err;
+  if ((err = cx->GetRuntime()->FindPublicByName(name, &index)) != SP_ERROR_NONE)
+    return cx->ThrowNativeErrorEx(err, "No public named %s", name);
+
+  sp_latency_stats_t stats;
+  cx->GetRuntime()->GetPublicLatency(index, &stats);
+  PrintLatencyChecks(&stats);
+  return 0;
+}
+
+// Records each sample, shifted left by |shift|, into an empty histogram and
+// prints the non-empty buckets and the percentile bounds.
+static cell_t PrintLatencySamples(IPluginContext *cx, const cell_t *params)
+{
+  int err;
+  cell_t *samples;
+  if ((err = cx->LocalToPhysAddr(params[1], &samples)) != SP_ERROR_NONE)
+    return cx->ThrowNativeErrorEx(err, "Could not read argument");
+
+  sp_latency_stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  for (cell_t i = 0; i < params[2]; i++)
+    RecordLatency(&stats, uint64_t(uint32_t(samples[i])) << params[3]);
+
+  printf("buckets");
+  for (size_t i = 0; i < SP_LATENCY_BUCKETS; i++) {
+    if (stats.buckets[i])
+      printf(" %d:%d", int(i), int(stats.buckets[i]));
+  }
+  printf("\n");
+
+  static const int kPercentiles[] = {0, 50, 99, 100};
+  for (size_t i = 0; i < KE_ARRAY_LENGTH(kPercentiles); i++) {
+    uint64_t bound = sp_latency_percentile(&stats, kPercentiles[i] / 100.0);
+    printf("p%d %llu\n", kPercentiles[i], (unsigned long long)bound);
+  }
+  PrintLatencyChecks(&stats);
+  return 0;
+}
+
 static cell_t DumpStackTrace(IPluginContext *cx, const cell_t *params)
 {
   FrameIterator iter;
@@ -177,6 +307,36 @@ static cell_t ReportError(IPluginContext* cx, const cell_t *params)
   return 0;
 }
 
+static void WriteProfile(PluginRuntime *rt, const char *file)
+{
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.prof", file);
+
+  FILE *fp = fopen(path, "wt");
+  if (!fp) {
+    fprintf(stderr, "Could not open %s for writing\n", path);
+    return;
+  }
+  if (!rt->WriteMethodProfile(fp))
+    fprintf(stderr, "Could not write profile to %s\n", path);
+  fclose(fp);
+}
+
+static void WriteOpcodeProfile(PluginRuntime *rt, const char *file)
+{
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.opprof", file);
+
+  FILE *fp = fopen(path, "wt");
+  if (!fp) {
+    fprintf(stderr, "Could not open %s for writing\n", path);
+    return;
+  }
+  if (!rt->WriteOpcodeProfile(fp))
+    fprintf(stderr, "Could not write opcode profile to %s\n", path);
+  fclose(fp);
+}
+
 static int Execute(const char *file)
 {
   char error[255];
@@ -198,7 +358,19 @@ static int Execute(const char *file)
   BindNative(rt, "execute", DoExecute);
   BindNative(rt, "invoke", DoInvoke);
   BindNative(rt, "dump_stack_trace", DumpStackTrace);
+  BindNative(rt, "jit_enabled", JitEnabled);
+  BindNative(rt, "in_jit", InJit);
   BindNative(rt, "report_error", ReportError);
+  BindNative(rt, "count_format_specs", CountFormatSpecs);
+  BindNative(rt, "latency_tracking", LatencyTracking);
+  BindNative(rt, "print_public_latency", PrintPublicLatency);
+  BindNative(rt, "print_latency_samples", PrintLatencySamples);
+  BindVectorNative(rt, "sum_pairs", SumTuples, 2);
+  BindIntrinsic(rt, "strlen");
+  BindIntrinsic(rt, "strcmp");
+  BindIntrinsic(rt, "strcopy");
+  BindIntrinsic(rt, "StrCat");
+  BindIntrinsic(rt, "StrContains");
 
   IPluginFunction *fun = rt->GetFunctionByName("main");
   if (!fun)
@@ -215,6 +387,11 @@ static int Execute(const char *file)
     }
   }
 
+  if (sEnv->MethodCountersEnabled())
+    WriteProfile(rt, file);
+  if (sEnv->OpcodeCountersEnabled())
+    WriteOpcodeProfile(rt, file);
+
   return result;
 }
 
@@ -242,6 +419,14 @@ int main(int argc, char **argv)
 
   if (getenv("DISABLE_JIT") && getenv("DISABLE_JIT")[0] == '1')
     sEnv->SetJitEnabled(false);
+  if (getenv("JIT_THRESHOLD"))
+    sEnv->APIv2()->SetJitThreshold(atoi(getenv("JIT_THRESHOLD")));
+  if (getenv("WRITE_PROFILE") && getenv("WRITE_PROFILE")[0] == '1')
+    sEnv->SetMethodCountersEnabled(true);
+  if (getenv("OPCODE_PROFILE") && getenv("OPCODE_PROFILE")[0] == '1')
+    sEnv->SetOpcodeCountersEnabled(true);
+  if (getenv("DUMP_JIT") && getenv("DUMP_JIT")[0] == '1')
+    sEnv->SetJitDumpEnabled(true);
 
   ShellDebugListener debug;
   sEnv->SetDebugger(&debug);
@@ -8,17 +8,19 @@
 //   http://www.gnu.org/licenses/gpl.html
 //
 #include "smx-v1-image.h"
+#include "atom-table.h"
 #include "zlib/zlib.h"
 
 using namespace ke;
 using namespace sp;
 
-SmxV1Image::SmxV1Image(FILE *fp)
+SmxV1Image::SmxV1Image(FILE *fp, AtomTable *atoms)
  : FileReader(fp),
    hdr_(nullptr),
    header_strings_(nullptr),
    names_section_(nullptr),
    names_(nullptr),
+   atoms_(atoms),
    debug_names_section_(nullptr),
    debug_names_(nullptr),
    debug_syms_(nullptr),
@@ -170,6 +172,8 @@ SmxV1Image::validate()
     return false;
   if (!validateTags())
     return false;
+  if (!validateFormats())
+    return false;
 
   return true;
 }
@@ -231,8 +235,11 @@ SmxV1Image::validateCode()
     reinterpret_cast<const sp_file_code_t *>(buffer() + section->dataoffs);
   if (code->codeversion < SmxConsts::CODE_VERSION_SP1_MIN)
     return error("code version is too old, no longer supported");
-  if (code->codeversion > SmxConsts::CODE_VERSION_SP1_MAX)
+  if (code->codeversion > SmxConsts::CODE_VERSION_SP1_MAX &&
+      code->codeversion != SmxConsts::CODE_VERSION_SP1_COMPACT)
+  {
     return error("code version is too new, not supported");
+  }
   if (code->cellsize != 4)
     return error("unsupported cellsize");
   if (code->flags & ~CODEFLAG_DEBUG)
@@ -244,10 +251,49 @@ SmxV1Image::validateCode()
 
   const uint8_t *blob =
     reinterpret_cast<const uint8_t *>(code) + code->code;
+  if (code->codeversion == SmxConsts::CODE_VERSION_SP1_COMPACT)
+    return expandCompactCode(section, code, blob);
+
   code_ = Blob<sp_file_code_t>(section, code, blob, code->codesize);
   return true;
 }
 
+bool
+SmxV1Image::expandCompactCode(const Section *section, const sp_file_code_t *code,
+                              const uint8_t *blob)
+{
+  // Every varint ends in a byte with the high bit clear, so counting those
+  // gives the expanded size up front.
+  size_t cells = 0;
+  for (uint32_t i = 0; i < code->codesize; i++) {
+    if (!(blob[i] & 0x80))
+      cells++;
+  }
+  if (code->codesize && (blob[code->codesize - 1] & 0x80))
+    return error("truncated compact code");
+
+  expanded_code_ = MakeUnique<uint8_t[]>(cells * sizeof(cell_t));
+  cell_t *out = reinterpret_cast<cell_t *>(expanded_code_.get());
+
+  uint32_t pos = 0;
+  for (size_t i = 0; i < cells; i++) {
+    uint32_t value = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+      if (shift > 28)
+        return error("invalid compact code");
+      byte = blob[pos++];
+      value |= uint32_t(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    out[i] = cell_t(value >> 1) ^ -cell_t(value & 1);
+  }
+
+  code_ = Blob<sp_file_code_t>(section, code, expanded_code_.get(), cells * sizeof(cell_t));
+  return true;
+}
+
 bool
 SmxV1Image::validatePublics()
 {
@@ -263,9 +309,13 @@ SmxV1Image::validatePublics()
     reinterpret_cast<const sp_file_publics_t *>(buffer() + section->dataoffs);
   size_t length = section->size / sizeof(sp_file_publics_t);
 
+  if (!public_map_.init(16))
+    return error("out of memory");
   for (size_t i = 0; i < length; i++) {
     if (!validateName(publics[i].name))
       return error("invalid public name");
+    if (!internName(publics[i].name, i, &public_map_))
+      return error("out of memory");
   }
 
   publics_ = List<sp_file_publics_t>(publics, length);
@@ -287,9 +337,13 @@ SmxV1Image::validatePubvars()
     reinterpret_cast<const sp_file_pubvars_t *>(buffer() + section->dataoffs);
   size_t length = section->size / sizeof(sp_file_pubvars_t);
 
+  if (!pubvar_map_.init(16))
+    return error("out of memory");
   for (size_t i = 0; i < length; i++) {
     if (!validateName(pubvars[i].name))
       return error("invalid pubvar name");
+    if (!internName(pubvars[i].name, i, &pubvar_map_))
+      return error("out of memory");
   }
 
   pubvars_ = List<sp_file_pubvars_t>(pubvars, length);
@@ -311,9 +365,13 @@ SmxV1Image::validateNatives()
     reinterpret_cast<const sp_file_natives_t *>(buffer() + section->dataoffs);
   size_t length = section->size / sizeof(sp_file_natives_t);
 
+  if (!native_map_.init(16))
+    return error("out of memory");
   for (size_t i = 0; i < length; i++) {
     if (!validateName(natives[i].name))
       return error("invalid pubvar name");
+    if (!internName(natives[i].name, i, &native_map_))
+      return error("out of memory");
   }
 
   natives_ = List<sp_file_natives_t>(natives, length);
@@ -326,6 +384,39 @@ SmxV1Image::validateName(size_t offset)
   return offset < names_section_->size;
 }
 
+bool
+SmxV1Image::internName(size_t offset, size_t index, AtomIndexMap *map)
+{
+  const char *atom = atoms_->add(names_ + offset);
+  if (!atom)
+    return false;
+
+  // If a name appears twice, lookups find the first entry, as they did when
+  // the table was searched in order.
+  AtomIndexMap::Insert p = map->findForAdd(atom);
+  if (p.found())
+    return true;
+  return map->add(p, atom, uint32_t(index));
+}
+
+bool
+SmxV1Image::findName(AtomIndexMap *map, const char *name, size_t *indexp) const
+{
+  if (!map->elements())
+    return false;
+
+  const char *atom = atoms_->find(name);
+  if (!atom)
+    return false;
+
+  AtomIndexMap::Result r = map->find(atom);
+  if (!r.found())
+    return false;
+  if (indexp)
+    *indexp = r->value;
+  return true;
+}
+
 bool
 SmxV1Image::validateDebugInfo()
 {
@@ -418,6 +509,58 @@ SmxV1Image::validateTags()
   return true;
 }
 
+bool
+SmxV1Image::validateFormats()
+{
+  const Section *section = findSection(".formats");
+  if (!section)
+    return true;
+  const Section *spec_section = findSection(".formats.specs");
+  if (!spec_section)
+    return error("could not find .formats.specs section");
+  if (!validateSection(section) || (section->size % sizeof(sp_file_format_t)) != 0)
+    return error("invalid .formats section");
+  if (!validateSection(spec_section) ||
+      (spec_section->size % sizeof(sp_file_format_spec_t)) != 0)
+  {
+    return error("invalid .formats.specs section");
+  }
+
+  const sp_file_format_t *formats =
+    reinterpret_cast<const sp_file_format_t *>(buffer() + section->dataoffs);
+  size_t num_formats = section->size / sizeof(sp_file_format_t);
+  const sp_file_format_spec_t *specs =
+    reinterpret_cast<const sp_file_format_spec_t *>(buffer() + spec_section->dataoffs);
+  size_t num_specs = spec_section->size / sizeof(sp_file_format_spec_t);
+
+  // Natives index the string with these offsets, so every specifier must lie
+  // within its (terminated) string.
+  for (size_t i = 0; i < num_formats; i++) {
+    const sp_file_format_t &format = formats[i];
+    if (i > 0 && formats[i - 1].address >= format.address)
+      return error("unsorted .formats section");
+    if (format.address >= data_.length())
+      return error("invalid format string address");
+    if (format.first_spec > num_specs || format.num_specs > num_specs - format.first_spec)
+      return error("invalid format specifier range");
+
+    const char *str = reinterpret_cast<const char *>(data_.blob() + format.address);
+    size_t length = strnlen(str, data_.length() - format.address);
+    if (length == data_.length() - format.address)
+      return error("unterminated format string");
+
+    for (size_t j = 0; j < format.num_specs; j++) {
+      const sp_file_format_spec_t &spec = specs[format.first_spec + j];
+      if (spec.offset >= length || spec.length > length - spec.offset)
+        return error("invalid format specifier");
+    }
+  }
+
+  formats_ = List<sp_file_format_t>(formats, num_formats);
+  format_specs_ = List<sp_file_format_spec_t>(specs, num_specs);
+  return true;
+}
+
 auto
 SmxV1Image::DescribeCode() const -> Code
 {
@@ -429,6 +572,7 @@ SmxV1Image::DescribeCode() const -> Code
       code.version = CodeVersion::SP_1_0;
       break;
     case SmxConsts::CODE_VERSION_JIT_1_1:
+    case SmxConsts::CODE_VERSION_SP1_COMPACT:
       code.version = CodeVersion::SP_1_1;
       break;
     default:
@@ -464,15 +608,7 @@ SmxV1Image::GetNative(size_t index) const
 bool
 SmxV1Image::FindNative(const char *name, size_t *indexp) const
 {
-  for (size_t i = 0; i < natives_.length(); i++) {
-    const char *candidate = names_ + natives_[i].name;
-    if (strcmp(candidate, name) == 0) {
-      if (indexp)
-        *indexp = i;
-      return true;
-    }
-  }
-  return false;
+  return findName(&native_map_, name, indexp);
 }
 
 size_t
@@ -494,24 +630,7 @@ SmxV1Image::GetPublic(size_t index, uint32_t *offsetp, const char **namep) const
 bool
 SmxV1Image::FindPublic(const char *name, size_t *indexp) const
 {
-  int high = publics_.length() - 1;
-  int low = 0;
-  while (low <= high) {
-    int mid = (low + high) / 2;
-    const char *candidate = names_ + publics_[mid].name;
-    int diff = strcmp(candidate, name);
-    if (diff == 0) {
-      if (indexp) {
-        *indexp = mid;
-        return true;
-      }
-    }
-    if (diff < 0)
-      low = mid + 1;
-    else
-      high = mid - 1;
-  }
-  return false;
+  return findName(&public_map_, name, indexp);
 }
 
 size_t
@@ -533,24 +652,7 @@ SmxV1Image::GetPubvar(size_t index, uint32_t *offsetp, const char **namep) const
 bool
 SmxV1Image::FindPubvar(const char *name, size_t *indexp) const
 {
-  int high = pubvars_.length() - 1;
-  int low = 0;
-  while (low <= high) {
-    int mid = (low + high) / 2;
-    const char *candidate = names_ + pubvars_[mid].name;
-    int diff = strcmp(candidate, name);
-    if (diff == 0) {
-      if (indexp) {
-        *indexp = mid;
-        return true;
-      }
-    }
-    if (diff < 0)
-      low = mid + 1;
-    else
-      high = mid - 1;
-  }
-  return false;
+  return findName(&pubvar_map_, name, indexp);
 }
 
 size_t
@@ -646,3 +748,30 @@ SmxV1Image::LookupLine(uint32_t addr, uint32_t *line)
   *line = debug_lines_[low].line + 1;
   return true;
 }
+
+bool
+SmxV1Image::LookupFormat(uint32_t address, const sp_format_spec_t **specs,
+                         uint32_t *count) const
+{
+  static_assert(sizeof(sp_format_spec_t) == sizeof(sp_file_format_spec_t),
+                "format specifier layouts must match");
+
+  size_t low = 0;
+  size_t high = formats_.length();
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (formats_[mid].address < address)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low == formats_.length() || formats_[low].address != address)
+    return false;
+
+  const sp_file_format_t &format = formats_[low];
+  *specs = format.num_specs
+           ? reinterpret_cast<const sp_format_spec_t *>(&format_specs_[format.first_spec])
+           : nullptr;
+  *count = format.num_specs;
+  return true;
+}
@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <smx/smx-headers.h>
 #include <smx/smx-v1.h>
+#include <am-hashmap.h>
 #include <am-string.h>
 #include <am-vector.h>
 #include "file-utils.h"
@@ -20,12 +21,14 @@
 
 namespace sp {
 
+class AtomTable;
+
 class SmxV1Image
   : public FileReader,
     public LegacyImage
 {
  public:
-  SmxV1Image(FILE *fp);
+  SmxV1Image(FILE *fp, AtomTable *atoms);
 
   // This must be called to initialize the reader.
   bool validate();
@@ -55,6 +58,8 @@ class SmxV1Image
   const char *LookupFile(uint32_t code_offset) override;
   const char *LookupFunction(uint32_t code_offset) override;
   bool LookupLine(uint32_t code_offset, uint32_t *line) override;
+  bool LookupFormat(uint32_t address, const sp_format_spec_t **specs,
+                    uint32_t *count) const override;
 
  private:
    struct Section
@@ -161,14 +166,29 @@ class SmxV1Image
     return false;
   }
   bool validateName(size_t offset);
+  struct AtomIndexPolicy {
+    static inline uint32_t hash(const char *atom) {
+      return ke::HashPointer(atom);
+    }
+    static inline bool matches(const char *a, const char *b) {
+      return a == b;
+    }
+  };
+  typedef ke::HashMap<const char *, uint32_t, AtomIndexPolicy> AtomIndexMap;
+
+  bool internName(size_t offset, size_t index, AtomIndexMap *map);
+  bool findName(AtomIndexMap *map, const char *name, size_t *indexp) const;
   bool validateSection(const Section *section);
   bool validateCode();
+  bool expandCompactCode(const Section *section, const sp_file_code_t *code,
+                         const uint8_t *blob);
   bool validateData();
   bool validatePublics();
   bool validatePubvars();
   bool validateNatives();
   bool validateDebugInfo();
   bool validateTags();
+  bool validateFormats();
 
  private:
   template <typename SymbolType, typename DimType>
@@ -183,12 +203,23 @@ class SmxV1Image
   const Section *names_section_;
   const char *names_;
 
+  // Public, pubvar and native indexes, keyed by the atom of their name. A
+  // lookup finds the caller's string in the atom table once, then hashes
+  // the pointer. The maps are only written while validating.
+  AtomTable *atoms_;
+  mutable AtomIndexMap public_map_;
+  mutable AtomIndexMap pubvar_map_;
+  mutable AtomIndexMap native_map_;
+
   Blob<sp_file_code_t> code_;
+  ke::UniquePtr<uint8_t[]> expanded_code_;
   Blob<sp_file_data_t> data_;
   List<sp_file_publics_t> publics_;
   List<sp_file_natives_t> natives_;
   List<sp_file_pubvars_t> pubvars_;
   List<sp_file_tag_t> tags_;
+  List<sp_file_format_t> formats_;
+  List<sp_file_format_spec_t> format_specs_;
 
   const Section *debug_names_section_;
   const char *debug_names_;
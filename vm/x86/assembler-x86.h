@@ -336,6 +336,10 @@ class Assembler : public AssemblerBase
   }
 
   void movl(Register dest, Register src) {
+    // A register-to-register move onto itself is a no-op on x86, and the JIT
+    // produces these when pri/alt happen to already hold the value.
+    if (dest.code == src.code)
+      return;
     emit1(0x89, src.code, dest.code);
   }
   void movl(Register dest, const Operand &src) {
@@ -222,6 +222,11 @@ Compiler::emitPrologue()
 {
   __ enterFrame(JitFrameType::Scripted, pcode_start_);
 
+  if (env_->MethodCountersEnabled()) {
+    RefPtr<MethodInfo> method = rt_->GetMethod(pcode_start_);
+    __ addl(Operand(ExternalAddress(method->addressOfInvocationCount())), 1);
+  }
+
   // Push the old frame onto the stack.
   __ movl(tmp, Operand(frmAddr()));
   __ movl(Operand(stk, -4), tmp);
@@ -234,6 +239,14 @@ Compiler::emitPrologue()
   __ movl(Operand(frmAddr()), tmp);
 }
 
+void
+Compiler::emitIncrementCounter(uint64_t* counter)
+{
+  uint32_t* words = reinterpret_cast<uint32_t*>(counter);
+  __ addl(Operand(ExternalAddress(&words[0])), 1);
+  __ adcl(Operand(ExternalAddress(&words[1])), 0);
+}
+
 bool
 Compiler::visitSHL()
 {
@@ -277,8 +290,8 @@ bool
 Compiler::visitNOT()
 {
   __ testl(eax, eax);
-  __ movl(eax, 0);
   __ set(zero, r8_al);
+  __ movzxb(eax, r8_al);
   return true;
 }
 
@@ -327,8 +340,36 @@ Compiler::visitADD_C(cell_t value)
 bool
 Compiler::visitSMUL_C(cell_t value)
 {
-  __ imull(pri, pri, value);
-  return true;
+  // The peephole optimizer folds every multiplication by a constant into
+  // SMUL_C, which makes this the index arithmetic for most array and enum
+  // struct accesses. Strength-reduce the common factors; all of these wrap
+  // exactly like imul does.
+  switch (value) {
+  case 0:
+    __ xorl(pri, pri);
+    return true;
+  case 1:
+    return true;
+  case -1:
+    __ negl(pri);
+    return true;
+  case 3:
+    __ lea(pri, Operand(pri, pri, ScaleTwo));
+    return true;
+  case 5:
+    __ lea(pri, Operand(pri, pri, ScaleFour));
+    return true;
+  case 9:
+    __ lea(pri, Operand(pri, pri, ScaleEight));
+    return true;
+  default:
+    if (value > 0 && ke::IsPowerOfTwo(size_t(value))) {
+      __ shll(pri, uint8_t(ke::Log2(size_t(value))));
+      return true;
+    }
+    __ imull(pri, pri, value);
+    return true;
+  }
 }
 
 bool
@@ -336,8 +377,8 @@ Compiler::visitCompareOp(CompareOp op)
 {
   ConditionCode cc = OpToCondition(op);
   __ cmpl(pri, alt);
-  __ movl(pri, 0);
   __ set(cc, r8_al);
+  __ movzxb(pri, r8_al);
   return true;
 }
 
@@ -346,8 +387,8 @@ Compiler::visitEQ_C(PawnReg src, cell_t value)
 {
   Register reg = (src == PawnReg::Pri) ? pri : alt;
   __ cmpl(reg, value);
-  __ movl(pri, 0);
   __ set(equal, r8_al);
+  __ movzxb(pri, r8_al);
   return true;
 }
 
@@ -1107,14 +1148,19 @@ Compiler::visitBOUNDS(uint32_t limit)
 void
 Compiler::emitCheckAddress(Register reg)
 {
+  // Anything below hp is in the data or heap region, and hp never exceeds
+  // the memory size, so test that first: globals and heap arrays then cost
+  // a single unsigned compare. This also rejects negative addresses, which
+  // are huge when treated as unsigned.
+  Label done;
+  __ cmpl(reg, Operand(hpAddr()));
+  __ j(below, &done);
+
   // Check if we're in memory bounds.
   __ cmpl(reg, context_->HeapSize());
   jumpOnError(not_below, SP_ERROR_MEMACCESS);
 
   // Check if we're in the invalid region between hp and sp.
-  Label done;
-  __ cmpl(reg, Operand(hpAddr()));
-  __ j(below, &done);
   __ lea(tmp, Operand(dat, reg, NoScale));
   __ cmpl(tmp, stk);
   jumpOnError(below, SP_ERROR_MEMACCESS);
@@ -1209,7 +1255,9 @@ Compiler::visitCALL(cell_t offset)
     // Need to emit a delayed thunk.
     CallThunk* thunk = new CallThunk(offset);
     __ callWithABI(thunk->label());
-    if (!ool_paths_.append(thunk)) {
+    if (!ool_paths_.append(thunk) ||
+        !thunked_calls_.append(ThunkedCall(masm.pc(), offset)))
+    {
       reportError(SP_ERROR_OUT_OF_MEMORY);
       return false;
     }
@@ -1280,6 +1328,17 @@ Compiler::visitSYSREQ_C(uint32_t native_index)
 void
 Compiler::emitLegacyNativeCall(uint32_t native_index, NativeEntry* native)
 {
+  if (env_->OpcodeCountersEnabled())
+    emitIncrementCounter(&native->call_count);
+
+  // Check whether the native is bound.
+  bool immutable = native->status == SP_NATIVE_BOUND &&
+                   !(native->flags & (SP_NTVFLAG_EPHEMERAL|SP_NTVFLAG_OPTIONAL));
+  if (immutable && native->intrinsic) {
+    emitIntrinsicCall(native->intrinsic);
+    return;
+  }
+
   CodeLabel return_address;
   __ enterInlineExitFrame(ExitFrameType::Native, native_index, &return_address);
 
@@ -1292,9 +1351,6 @@ Compiler::emitLegacyNativeCall(uint32_t native_index, NativeEntry* native)
   // Save registers.
   __ push(edx);
 
-  // Check whether the native is bound.
-  bool immutable = native->status == SP_NATIVE_BOUND &&
-                   !(native->flags & (SP_NTVFLAG_EPHEMERAL|SP_NTVFLAG_OPTIONAL));
   if (!immutable) {
     __ movl(edx, Operand(ExternalAddress(&native->legacy_fn)));
     __ testl(edx, edx);
@@ -1344,6 +1400,38 @@ Compiler::emitLegacyNativeCall(uint32_t native_index, NativeEntry* native)
   __ j(not_zero, &return_reported_error_);
 }
 
+void
+Compiler::emitIntrinsicCall(IntrinsicFn intrinsic)
+{
+  // Intrinsics never re-enter the VM and return their error code instead of
+  // reporting it, so there is no exit frame and hp does not need saving. They
+  // do check addresses against sp, so the context's view must be current.
+  __ movl(tmp, stk);
+  __ subl(tmp, dat);
+  __ movl(Operand(spAddr()), tmp);
+
+  // Padding, ALT, and the result slot; with the three arguments this keeps
+  // the stack aligned.
+  __ subl(esp, 12);
+  __ push(edx);
+  __ subl(esp, 4);
+  __ movl(tmp, esp);
+
+  __ push(tmp);
+  __ push(stk);
+  __ push(intptr_t(rt_->GetBaseContext()));
+  __ callWithABI(ExternalAddress((void *)intrinsic));
+
+  // Restore ALT and take the result before the stack is released, then check
+  // the error code in eax with the stack back at its aligned resting point.
+  __ movl(tmp, Operand(esp, 3 * sizeof(intptr_t)));
+  __ movl(edx, Operand(esp, 4 * sizeof(intptr_t)));
+  __ addl(esp, 8 * sizeof(intptr_t));
+  __ testl(eax, eax);
+  jumpOnError(not_zero);
+  __ movl(pri, tmp);
+}
+
 bool
 Compiler::visitSWITCH(cell_t defaultOffset,
                       const CaseTableEntry* cases,
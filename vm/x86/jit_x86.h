@@ -143,8 +143,10 @@ class Compiler : public CompilerBase
   void emitThrowPath(int err) override;
   void emitErrorHandlers() override;
   void emitOutOfBoundsErrorPath(OutOfBoundsErrorPath* path) override;
+  void emitIncrementCounter(uint64_t* counter) override;
 
   void emitLegacyNativeCall(uint32_t native_index, NativeEntry* native);
+  void emitIntrinsicCall(IntrinsicFn intrinsic);
   void emitGenArray(bool autozero);
   void emitCheckAddress(Register reg);
   void emitFloatCmp(ConditionCode cc);